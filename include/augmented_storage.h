@@ -0,0 +1,353 @@
+#ifndef AUGMENTED_STORAGE_H
+#define AUGMENTED_STORAGE_H
+
+#include "map_storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// map_storage for arithmetic keys that also answers range aggregates in
+// O(log n): measure(a, b) (how many keys in [a, b) differ from the begin
+// value), count_value(a, b, v) and kth_covered(k). Every distinct value owns
+// a treap of the intervals carrying it, keyed by interval start and
+// augmented with subtree length sums; storage updates keep the treaps in
+// step, at O(log n) per touched boundary. Requires std::hash<V>.
+template<typename K, typename V, typename Alloc = std::allocator<std::pair<const K, V>>>
+class augmented_storage {
+    static_assert(std::is_arithmetic_v<K>, "augmented_storage needs arithmetic keys");
+
+public:
+    using measure_type = std::conditional_t<std::is_floating_point_v<K>, K, unsigned long long>;
+
+private:
+    // Intervals of one value: start key -> length to the next boundary. The
+    // last boundary's interval is unbounded and recorded with length 0.
+    class length_tree {
+    private:
+        struct node {
+            K key;
+            measure_type len;
+            measure_type sum;
+            std::uint32_t priority;
+            std::unique_ptr<node> left;
+            std::unique_ptr<node> right;
+        };
+        using node_ptr = std::unique_ptr<node>;
+
+        node_ptr m_root;
+        std::uint32_t m_seed = 2463534242u;
+
+        std::uint32_t next_priority() {
+            m_seed ^= m_seed << 13;
+            m_seed ^= m_seed >> 17;
+            m_seed ^= m_seed << 5;
+            return m_seed;
+        }
+
+        static measure_type sum_of(node_ptr const& t) { return t ? t->sum : measure_type(0); }
+        static void pull(node* t) { t->sum = sum_of(t->left) + t->len + sum_of(t->right); }
+
+        // Splits t into keys < key and keys >= key
+        static std::pair<node_ptr, node_ptr> split(node_ptr t, K const& key) {
+            if (!t) return {};
+            if (t->key < key) {
+                auto [l, r] = split(std::move(t->right), key);
+                t->right = std::move(l);
+                pull(t.get());
+                return {std::move(t), std::move(r)};
+            }
+            auto [l, r] = split(std::move(t->left), key);
+            t->left = std::move(r);
+            pull(t.get());
+            return {std::move(l), std::move(t)};
+        }
+
+        static node_ptr merge(node_ptr a, node_ptr b) {
+            if (!a) return b;
+            if (!b) return a;
+            if (a->priority > b->priority) {
+                a->right = merge(std::move(a->right), std::move(b));
+                pull(a.get());
+                return a;
+            }
+            b->left = merge(std::move(a), std::move(b->left));
+            pull(b.get());
+            return b;
+        }
+
+        static void erase(node_ptr& t, K const& key) {
+            if (!t) return;
+            if (key < t->key) {
+                erase(t->left, key);
+            } else if (t->key < key) {
+                erase(t->right, key);
+            } else {
+                t = merge(std::move(t->left), std::move(t->right));
+                if (!t) return;
+            }
+            pull(t.get());
+        }
+
+        static node_ptr clone(node_ptr const& t) {
+            if (!t) return nullptr;
+            return node_ptr(new node{t->key, t->len, t->sum, t->priority, clone(t->left), clone(t->right)});
+        }
+
+        static void update(node* t, K const& key, measure_type len) {
+            if (!t) return;
+            if (key < t->key) {
+                update(t->left.get(), key, len);
+            } else if (t->key < key) {
+                update(t->right.get(), key, len);
+            } else {
+                t->len = len;
+            }
+            pull(t);
+        }
+
+    public:
+        static constexpr std::size_t node_bytes = sizeof(node);
+
+        // Copies are deep, so augmented maps copy like any other
+        length_tree() = default;
+        length_tree(length_tree const& other) : m_root(clone(other.m_root)), m_seed(other.m_seed) {}
+        length_tree(length_tree&&) = default;
+        length_tree& operator=(length_tree const& other) {
+            m_root = clone(other.m_root);
+            m_seed = other.m_seed;
+            return *this;
+        }
+        length_tree& operator=(length_tree&&) = default;
+
+        bool empty() const { return !m_root; }
+
+        void insert(K const& key, measure_type len) {
+            auto [l, r] = split(std::move(m_root), key);
+            node_ptr created(new node{key, len, len, next_priority(), nullptr, nullptr});
+            m_root = merge(merge(std::move(l), std::move(created)), std::move(r));
+        }
+        void erase(K const& key) { erase(m_root, key); }
+        void update(K const& key, measure_type len) { update(m_root.get(), key, len); }
+
+        // Length of this value's intervals inside (-inf, x)
+        measure_type prefix(K const& x) const {
+            measure_type sum = 0;
+            node const* last = nullptr;
+            for (node const* t = m_root.get(); t;) {
+                if (t->key < x) {
+                    sum += sum_of(t->left) + t->len;
+                    last = t;
+                    t = t->right.get();
+                } else {
+                    t = t->left.get();
+                }
+            }
+            if (!last) return 0;
+            // The interval containing x only counts up to x
+            measure_type partial = length(last->key, x);
+            if (last->len == 0 || partial < last->len) {
+                sum = sum - last->len + partial;
+            }
+            return sum;
+        }
+
+        // The last interval of this value with at most k other keys between
+        // origin and its start; gap receives that count. nullptr if none.
+        node const* last_with_gap_at_most(K const& origin, measure_type k, measure_type& gap) const {
+            node const* found = nullptr;
+            measure_type before = 0;
+            for (node const* t = m_root.get(); t;) {
+                measure_type sumBefore = before + sum_of(t->left);
+                measure_type candidateGap = length(origin, t->key) - sumBefore;
+                if (candidateGap <= k) {
+                    found = t;
+                    gap = candidateGap;
+                    before = sumBefore + t->len;
+                    t = t->right.get();
+                } else {
+                    t = t->left.get();
+                }
+            }
+            return found;
+        }
+
+        static K const& key_of(node const* t) { return t->key; }
+        static measure_type len_of(node const* t) { return t->len; }
+    };
+
+    map_storage<K, V, Alloc> m_base;
+    std::unordered_map<V, length_tree> m_trees;
+    std::optional<V> m_default;
+
+    static measure_type length(K const& a, K const& b) {
+        if constexpr (std::is_floating_point_v<K>) {
+            return b - a;
+        } else {
+            return static_cast<measure_type>(b) - static_cast<measure_type>(a);
+        }
+    }
+
+    static K advance(K const& key, measure_type n) {
+        if constexpr (std::is_floating_point_v<K>) {
+            return key + n;
+        } else {
+            return static_cast<K>(static_cast<measure_type>(key) + n);
+        }
+    }
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using stored_type = V;
+    using allocator_type = Alloc;
+    using iterator = typename map_storage<K, V, Alloc>::iterator;
+    using const_iterator = typename map_storage<K, V, Alloc>::const_iterator;
+
+private:
+    measure_type interval_length(const_iterator it) const {
+        auto next = std::next(it);
+        return next == m_base.end() ? measure_type(0) : length(it->first, next->first);
+    }
+
+    void track(const_iterator it) { m_trees[it->second].insert(it->first, interval_length(it)); }
+
+    void untrack(const_iterator it) {
+        auto found = m_trees.find(it->second);
+        found->second.erase(it->first);
+        if (found->second.empty()) {
+            m_trees.erase(found);
+        }
+    }
+
+    // Refreshes the length of the interval before it after a neighbour change
+    void retrack_previous(const_iterator it) {
+        if (it == m_base.begin()) return;
+        auto prev = std::prev(it);
+        m_trees[prev->second].update(prev->first, interval_length(prev));
+    }
+
+    // Number of keys in [a, b) before the first boundary, where the begin value holds
+    measure_type leading_default(K const& a, K const& b) const {
+        if (m_base.empty()) return length(a, b);
+        K const& first = m_base.key(m_base.begin());
+        if (!(a < first)) return 0;
+        return length(a, b < first ? b : first);
+    }
+
+public:
+    augmented_storage() = default;
+    explicit augmented_storage(Alloc const& alloc) : m_base(alloc) {}
+
+    iterator begin() { return m_base.begin(); }
+    iterator end() { return m_base.end(); }
+    const_iterator begin() const { return m_base.begin(); }
+    const_iterator end() const { return m_base.end(); }
+
+    bool empty() const { return m_base.empty(); }
+    std::size_t size() const { return m_base.size(); }
+    void clear() {
+        m_base.clear();
+        m_trees.clear();
+    }
+
+    iterator lower_bound(K const& key) { return m_base.lower_bound(key); }
+    iterator upper_bound(K const& key) { return m_base.upper_bound(key); }
+    const_iterator lower_bound(K const& key) const { return m_base.lower_bound(key); }
+    const_iterator upper_bound(K const& key) const { return m_base.upper_bound(key); }
+    const_iterator upper_bound_from(const_iterator it, K const& key) const { return m_base.upper_bound_from(it, key); }
+    iterator to_mutable(const_iterator it) { return m_base.to_mutable(it); }
+
+    void bind_begin_value(V const& valBegin) { m_default = valBegin; }
+    V const& stored_begin(V const& valBegin) const { return valBegin; }
+    V const& intern(V const& val) { return val; }
+
+    K const& key(const_iterator it) const { return m_base.key(it); }
+    V const& value(const_iterator it) const { return m_base.value(it); }
+    V const& stored(const_iterator it) const { return m_base.stored(it); }
+    void set_stored(iterator it, V const& val) {
+        untrack(it);
+        m_base.set_stored(it, val);
+        track(it);
+    }
+
+    // Inserts a boundary that sorts immediately before hint
+    iterator insert(iterator hint, K const& key, V const& val) {
+        iterator it = m_base.insert(hint, key, val);
+        track(it);
+        retrack_previous(it);
+        return it;
+    }
+
+    iterator erase(iterator first, iterator last) {
+        if (first == last) return last;
+        for (const_iterator it = first; it != last; ++it) {
+            untrack(it);
+        }
+        iterator next = m_base.erase(first, last);
+        retrack_previous(next);
+        return next;
+    }
+
+    // Adds a boundary greater than every existing one in amortized O(1)
+    void append(K key, V val) {
+        m_base.append(std::move(key), std::move(val));
+        iterator it = std::prev(m_base.end());
+        track(it);
+        retrack_previous(it);
+    }
+
+    // Approximate bytes held: the boundary tree, one length node per boundary
+    // and the per-value table
+    std::size_t memory_usage() const {
+        return m_base.memory_usage() + m_base.size() * length_tree::node_bytes +
+               m_trees.bucket_count() * sizeof(void*) +
+               m_trees.size() * (sizeof(void*) + sizeof(typename decltype(m_trees)::value_type));
+    }
+
+    // Number of keys in [a, b) mapped to val
+    measure_type count_value(K const& a, K const& b, V const& val) const {
+        if (!(a < b)) return 0;
+        measure_type result = 0;
+        auto found = m_trees.find(val);
+        if (found != m_trees.end()) {
+            result = found->second.prefix(b) - found->second.prefix(a);
+        }
+        if (m_default && *m_default == val) {
+            result += leading_default(a, b);
+        }
+        return result;
+    }
+
+    // Number of keys in [a, b) whose value differs from the begin value
+    measure_type measure(K const& a, K const& b) const {
+        if (!(a < b)) return 0;
+        return length(a, b) - count_value(a, b, *m_default);
+    }
+
+    // The k-th (0-based) key in ascending order whose value differs from the
+    // begin value; throws std::out_of_range when fewer keys are covered
+    K kth_covered(measure_type k) const {
+        if (m_base.empty()) {
+            throw std::out_of_range("augmented_storage::kth_covered: nothing is covered");
+        }
+        // Coverage starts at the first boundary, whose value is never the
+        // begin value; default intervals after it are the gaps to skip
+        K const& origin = m_base.key(m_base.begin());
+        auto found = m_trees.find(*m_default);
+        measure_type gap = 0;
+        auto const* run = found == m_trees.end() ? nullptr : found->second.last_with_gap_at_most(origin, k, gap);
+        if (!run) return advance(origin, k);
+        if (length_tree::len_of(run) == 0) {
+            throw std::out_of_range("augmented_storage::kth_covered: fewer covered keys than requested");
+        }
+        return advance(length_tree::key_of(run), length_tree::len_of(run) + (k - gap));
+    }
+};
+
+#endif // AUGMENTED_STORAGE_H
@@ -0,0 +1,42 @@
+#ifndef BUFFERED_INTERVAL_MAP_H
+#define BUFFERED_INTERVAL_MAP_H
+
+#include "interval_map.h"
+#include <cstddef>
+#include <vector>
+
+// interval_map that defers writes: assign appends to a pending log in O(1)
+// and leaves the boundaries alone. The next read (or flush()) resolves the
+// log with assign_batch, so assignments overwritten before anyone looked
+// never touch the boundaries, and the survivors go in as one sorted batch.
+// Every read sees exactly what eager assigns would have produced. Reads
+// modify internal state: unlike interval_map, concurrent const calls are
+// not safe.
+template<typename K, typename V, typename Storage = default_storage_t<K, V>>
+class buffered_interval_map {
+private:
+    mutable interval_map<K, V, Storage> m_map;
+    mutable std::vector<interval_assignment<K, V>> m_pending;
+    std::size_t m_maxPending;
+
+public:
+    // The log is flushed on its own once maxPending assignments queue up
+    explicit buffered_interval_map(V const& val, std::size_t maxPending = 65536);
+
+    void assign(K const& keyBegin, K const& keyEnd, V const& val);
+    void flush() const;
+    std::size_t pending() const;
+
+    // Reads flush the log first
+    V const& operator[](K const& key) const;
+    std::size_t size() const;
+    V const& get_begin_value() const;
+    interval_map<K, V, Storage> const& map() const;
+    typename interval_map<K, V, Storage>::interval_range intervals(K const& keyBegin, K const& keyEnd) const;
+    template<typename F>
+    void for_each_interval(K const& keyBegin, K const& keyEnd, F&& f) const;
+};
+
+#include "buffered_interval_map_impl.h"
+
+#endif // BUFFERED_INTERVAL_MAP_H
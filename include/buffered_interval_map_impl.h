@@ -0,0 +1,76 @@
+#ifndef BUFFERED_INTERVAL_MAP_IMPL_H
+#define BUFFERED_INTERVAL_MAP_IMPL_H
+
+#include "buffered_interval_map.h"
+#include <algorithm>
+#include <utility>
+
+template<typename K, typename V, typename Storage>
+buffered_interval_map<K, V, Storage>::buffered_interval_map(V const& val, std::size_t maxPending)
+    : m_map(val), m_maxPending(std::max<std::size_t>(maxPending, 1)) {}
+
+template<typename K, typename V, typename Storage>
+void buffered_interval_map<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    if (!(keyBegin < keyEnd)) return;
+    // Rewrites of the same range replace their predecessors right away
+    while (!m_pending.empty() && !(m_pending.back().keyBegin < keyBegin) && !(keyEnd < m_pending.back().keyEnd)) {
+        m_pending.pop_back();
+    }
+    m_pending.push_back({keyBegin, keyEnd, val});
+    if (m_pending.size() >= m_maxPending) {
+        flush();
+    }
+}
+
+template<typename K, typename V, typename Storage>
+void buffered_interval_map<K, V, Storage>::flush() const {
+    if (m_pending.empty()) return;
+    // assign_batch drops overwritten pieces and picks per-interval assigns or
+    // one linear merge depending on how the batch compares to the map
+    m_map.assign_batch(m_pending);
+    m_pending.clear();
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t buffered_interval_map<K, V, Storage>::pending() const {
+    return m_pending.size();
+}
+
+template<typename K, typename V, typename Storage>
+V const& buffered_interval_map<K, V, Storage>::operator[](K const& key) const {
+    flush();
+    return m_map[key];
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t buffered_interval_map<K, V, Storage>::size() const {
+    flush();
+    return m_map.size();
+}
+
+template<typename K, typename V, typename Storage>
+V const& buffered_interval_map<K, V, Storage>::get_begin_value() const {
+    return m_map.get_begin_value();
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage> const& buffered_interval_map<K, V, Storage>::map() const {
+    flush();
+    return m_map;
+}
+
+template<typename K, typename V, typename Storage>
+typename interval_map<K, V, Storage>::interval_range
+buffered_interval_map<K, V, Storage>::intervals(K const& keyBegin, K const& keyEnd) const {
+    flush();
+    return m_map.intervals(keyBegin, keyEnd);
+}
+
+template<typename K, typename V, typename Storage>
+template<typename F>
+void buffered_interval_map<K, V, Storage>::for_each_interval(K const& keyBegin, K const& keyEnd, F&& f) const {
+    flush();
+    m_map.for_each_interval(keyBegin, keyEnd, std::forward<F>(f));
+}
+
+#endif // BUFFERED_INTERVAL_MAP_IMPL_H
@@ -0,0 +1,83 @@
+#ifndef CONCURRENT_INTERVAL_MAP_H
+#define CONCURRENT_INTERVAL_MAP_H
+
+#include "interval_map.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// interval_map shared between many readers and writers, RCU style. Readers
+// work on an immutable published version and never block: a lookup is a few
+// atomic loads and stores plus the lookup itself. Writers queue assignments
+// and publish them as a new version (a copy of the current one with the batch
+// applied), swapped in atomically. Replaced versions are freed once no reader
+// that could still see them is active, using epoch-based reclamation.
+template<typename K, typename V, typename Storage = default_storage_t<K, V>>
+class concurrent_interval_map {
+public:
+    using map_type = interval_map<K, V, Storage>;
+
+private:
+    static constexpr std::uint64_t IDLE = ~std::uint64_t(0);
+
+    struct alignas(64) reader_slot {
+        std::atomic<std::uint64_t> epoch{IDLE};
+        std::atomic<bool> claimed{false};
+    };
+
+    std::atomic<map_type const*> m_current;
+    std::atomic<std::uint64_t> m_epoch{0};
+    std::unique_ptr<reader_slot[]> m_slots;
+    std::size_t m_slotCount;
+
+    std::mutex m_writeMutex;
+    std::size_t m_batchSize;
+    std::vector<interval_assignment<K, V>> m_pending;
+    std::vector<std::pair<map_type const*, std::uint64_t>> m_retired;
+
+    void publish_locked();
+    void reclaim_locked();
+
+public:
+    // A registered reader; each thread reading concurrently needs its own.
+    class reader {
+    private:
+        concurrent_interval_map const* m_owner;
+        reader_slot* m_slot;
+
+    public:
+        reader(concurrent_interval_map const* owner, reader_slot* slot);
+        reader(reader&& other) noexcept;
+        reader(reader const&) = delete;
+        reader& operator=(reader const&) = delete;
+        reader& operator=(reader&&) = delete;
+        ~reader();
+
+        V operator[](K const& key) const;
+
+        // Runs f on one consistent version; f must not keep references to it.
+        template<typename F>
+        decltype(auto) read(F&& f) const;
+    };
+
+    concurrent_interval_map(V const& val, std::size_t maxReaders = 256, std::size_t batchSize = 1024);
+    concurrent_interval_map(concurrent_interval_map const&) = delete;
+    concurrent_interval_map& operator=(concurrent_interval_map const&) = delete;
+    ~concurrent_interval_map();
+
+    // Throws std::runtime_error when all maxReaders slots are taken
+    reader make_reader() const;
+
+    // Queues an assignment; publishes once batchSize assignments are pending
+    void assign(K const& keyBegin, K const& keyEnd, V const& val);
+    // Makes every queued assignment visible to readers
+    void publish();
+};
+
+#include "concurrent_interval_map_impl.h"
+
+#endif // CONCURRENT_INTERVAL_MAP_H
@@ -0,0 +1,114 @@
+#ifndef CONCURRENT_INTERVAL_MAP_IMPL_H
+#define CONCURRENT_INTERVAL_MAP_IMPL_H
+
+#include "concurrent_interval_map.h"
+#include <algorithm>
+#include <stdexcept>
+
+template<typename K, typename V, typename Storage>
+concurrent_interval_map<K, V, Storage>::concurrent_interval_map(V const& val, std::size_t maxReaders, std::size_t batchSize)
+    : m_current(new map_type(val)), m_slots(new reader_slot[maxReaders]), m_slotCount(maxReaders),
+      m_batchSize(std::max<std::size_t>(batchSize, 1)) {}
+
+template<typename K, typename V, typename Storage>
+concurrent_interval_map<K, V, Storage>::~concurrent_interval_map() {
+    delete m_current.load();
+    for (auto const& [map, epoch] : m_retired) {
+        delete map;
+    }
+}
+
+template<typename K, typename V, typename Storage>
+typename concurrent_interval_map<K, V, Storage>::reader
+concurrent_interval_map<K, V, Storage>::make_reader() const {
+    for (std::size_t i = 0; i < m_slotCount; ++i) {
+        bool expected = false;
+        if (m_slots[i].claimed.compare_exchange_strong(expected, true)) {
+            return reader(this, &m_slots[i]);
+        }
+    }
+    throw std::runtime_error("concurrent_interval_map: no free reader slot");
+}
+
+template<typename K, typename V, typename Storage>
+void concurrent_interval_map<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_pending.push_back({keyBegin, keyEnd, val});
+    if (m_pending.size() >= m_batchSize) {
+        publish_locked();
+    }
+}
+
+template<typename K, typename V, typename Storage>
+void concurrent_interval_map<K, V, Storage>::publish() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    publish_locked();
+}
+
+template<typename K, typename V, typename Storage>
+void concurrent_interval_map<K, V, Storage>::publish_locked() {
+    if (m_pending.empty()) return;
+
+    auto next = std::make_unique<map_type>(*m_current.load());
+    next->assign_batch(m_pending);
+    m_pending.clear();
+
+    // A reader announcing an epoch after the increment is guaranteed to load
+    // the new version, so the old one is only reachable from epochs <= retired.
+    map_type const* old = m_current.exchange(next.release());
+    m_retired.emplace_back(old, m_epoch.fetch_add(1));
+    reclaim_locked();
+}
+
+template<typename K, typename V, typename Storage>
+void concurrent_interval_map<K, V, Storage>::reclaim_locked() {
+    std::uint64_t oldestActive = IDLE;
+    for (std::size_t i = 0; i < m_slotCount; ++i) {
+        oldestActive = std::min(oldestActive, m_slots[i].epoch.load());
+    }
+
+    auto reclaimable = [&](auto const& retired) { return retired.second < oldestActive; };
+    for (auto const& retired : m_retired) {
+        if (reclaimable(retired)) {
+            delete retired.first;
+        }
+    }
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), reclaimable), m_retired.end());
+}
+
+template<typename K, typename V, typename Storage>
+concurrent_interval_map<K, V, Storage>::reader::reader(concurrent_interval_map const* owner, reader_slot* slot)
+    : m_owner(owner), m_slot(slot) {}
+
+template<typename K, typename V, typename Storage>
+concurrent_interval_map<K, V, Storage>::reader::reader(reader&& other) noexcept
+    : m_owner(other.m_owner), m_slot(other.m_slot) {
+    other.m_slot = nullptr;
+}
+
+template<typename K, typename V, typename Storage>
+concurrent_interval_map<K, V, Storage>::reader::~reader() {
+    if (m_slot) {
+        m_slot->claimed.store(false, std::memory_order_release);
+    }
+}
+
+template<typename K, typename V, typename Storage>
+V concurrent_interval_map<K, V, Storage>::reader::operator[](K const& key) const {
+    return read([&key](map_type const& map) { return map[key]; });
+}
+
+template<typename K, typename V, typename Storage>
+template<typename F>
+decltype(auto) concurrent_interval_map<K, V, Storage>::reader::read(F&& f) const {
+    // Sequentially consistent announce-then-load pairs with the writer's
+    // exchange-then-increment; see publish_locked().
+    struct guard {
+        reader_slot* slot;
+        ~guard() { slot->epoch.store(IDLE, std::memory_order_release); }
+    } active{m_slot};
+    m_slot->epoch.store(m_owner->m_epoch.load());
+    return f(*m_owner->m_current.load());
+}
+
+#endif // CONCURRENT_INTERVAL_MAP_IMPL_H
@@ -0,0 +1,135 @@
+#ifndef FLAT_STORAGE_H
+#define FLAT_STORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Contiguous interval_map backend for read-mostly workloads. Keys and values
+// live in separate sorted arrays so a lookup's binary search touches keys only.
+// Inserts and erases shift the arrays and invalidate all iterators.
+template<typename K, typename V, typename Alloc = std::allocator<std::pair<const K, V>>>
+class flat_storage {
+private:
+    template<typename T>
+    using rebind = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+    std::vector<K, rebind<K>> m_keys;
+    std::vector<V, rebind<V>> m_values;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using stored_type = V;
+    using allocator_type = Alloc;
+
+    class iterator {
+    private:
+        flat_storage const* m_storage = nullptr;
+        std::ptrdiff_t m_index = 0;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::pair<K const&, V const&>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator() = default;
+        iterator(flat_storage const* storage, std::ptrdiff_t index) : m_storage(storage), m_index(index) {}
+
+        std::ptrdiff_t index() const { return m_index; }
+        reference operator*() const { return {m_storage->m_keys[m_index], m_storage->m_values[m_index]}; }
+
+        iterator& operator++() { ++m_index; return *this; }
+        iterator& operator--() { --m_index; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++m_index; return tmp; }
+        iterator operator--(int) { iterator tmp = *this; --m_index; return tmp; }
+        iterator& operator+=(difference_type n) { m_index += n; return *this; }
+        iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+        iterator operator+(difference_type n) const { return iterator(m_storage, m_index + n); }
+        iterator operator-(difference_type n) const { return iterator(m_storage, m_index - n); }
+        difference_type operator-(iterator const& other) const { return m_index - other.m_index; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        bool operator==(iterator const& other) const { return m_index == other.m_index; }
+        bool operator!=(iterator const& other) const { return m_index != other.m_index; }
+        bool operator<(iterator const& other) const { return m_index < other.m_index; }
+        bool operator>(iterator const& other) const { return m_index > other.m_index; }
+        bool operator<=(iterator const& other) const { return m_index <= other.m_index; }
+        bool operator>=(iterator const& other) const { return m_index >= other.m_index; }
+    };
+    using const_iterator = iterator;
+
+    flat_storage() = default;
+    explicit flat_storage(Alloc const& alloc) : m_keys(rebind<K>(alloc)), m_values(rebind<V>(alloc)) {}
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, static_cast<std::ptrdiff_t>(m_keys.size())); }
+
+    bool empty() const { return m_keys.empty(); }
+    std::size_t size() const { return m_keys.size(); }
+    void clear() { m_keys.clear(); m_values.clear(); }
+
+    iterator lower_bound(K const& key) const {
+        return iterator(this, std::lower_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin());
+    }
+    iterator upper_bound(K const& key) const {
+        return iterator(this, std::upper_bound(m_keys.begin(), m_keys.end(), key) - m_keys.begin());
+    }
+
+    // upper_bound(key) for a key no smaller than every boundary before it,
+    // found by galloping forward from it and finishing with a binary search.
+    iterator upper_bound_from(iterator it, K const& key) const {
+        const std::size_t n = m_keys.size();
+        std::size_t lo = static_cast<std::size_t>(it.index());
+        std::size_t pos = lo;
+        for (std::size_t step = 1; pos < n && !(key < m_keys[pos]); step *= 2) {
+            lo = pos + 1;
+            pos += step;
+        }
+        auto found = std::upper_bound(m_keys.begin() + lo, m_keys.begin() + std::min(pos, n), key);
+        return iterator(this, found - m_keys.begin());
+    }
+
+    // Iterators already permit modification
+    iterator to_mutable(iterator it) { return it; }
+
+    // Values are stored as they are; intern() hands out a copy so a value
+    // read from the map stays valid while the arrays shift
+    void bind_begin_value(V const&) {}
+    V const& stored_begin(V const& valBegin) const { return valBegin; }
+    V intern(V const& val) { return val; }
+
+    K const& key(iterator it) const { return m_keys[it.index()]; }
+    V const& value(iterator it) const { return m_values[it.index()]; }
+    V const& stored(iterator it) const { return m_values[it.index()]; }
+    void set_stored(iterator it, V const& val) { m_values[it.index()] = val; }
+
+    // Inserts a boundary that sorts immediately before hint
+    iterator insert(iterator hint, K const& key, V const& val) {
+        m_keys.insert(m_keys.begin() + hint.index(), key);
+        m_values.insert(m_values.begin() + hint.index(), val);
+        return iterator(this, hint.index());
+    }
+
+    iterator erase(iterator first, iterator last) {
+        m_keys.erase(m_keys.begin() + first.index(), m_keys.begin() + last.index());
+        m_values.erase(m_values.begin() + first.index(), m_values.begin() + last.index());
+        return iterator(this, first.index());
+    }
+
+    // Adds a boundary greater than every existing one in amortized O(1)
+    void append(K key, V val) {
+        m_keys.push_back(std::move(key));
+        m_values.push_back(std::move(val));
+    }
+
+    // Bytes reserved by the key and value arrays
+    std::size_t memory_usage() const { return m_keys.capacity() * sizeof(K) + m_values.capacity() * sizeof(V); }
+};
+
+#endif // FLAT_STORAGE_H
@@ -0,0 +1,42 @@
+#ifndef FROZEN_INTERVAL_MAP_H
+#define FROZEN_INTERVAL_MAP_H
+
+#include <cstddef>
+#include <vector>
+
+// Immutable snapshot of an interval_map tuned for lookups. Boundaries are
+// laid out in Eytzinger (BFS) order as a complete binary tree padded with
+// copies of the largest key, so every lookup descends exactly depth levels
+// without a data-dependent branch and can prefetch four levels ahead.
+template<typename K, typename V>
+class frozen_interval_map {
+private:
+    V m_valBegin;
+    std::vector<K> m_keys;      // 1-based Eytzinger order, slot 0 unused
+    std::vector<V> m_values;    // value in effect just before m_keys[i]; slot 0 holds the last value
+    std::size_t m_depth = 0;
+    std::size_t m_size = 0;
+
+    void fill(std::vector<K> const& keys, std::vector<V> const& before, std::size_t node, std::size_t& rank);
+    V const& resolve(std::size_t node) const;
+    void lookup_interleaved(const K* keys, std::size_t n, V* out) const;
+    bool lookup_vectorized(const K* keys, std::size_t n, V* out) const;
+
+public:
+    template<typename InputIt>
+    frozen_interval_map(V const& valBegin, InputIt first, InputIt last);
+
+    std::size_t size() const;
+    V const& get_begin_value() const;
+
+    V const& operator[](K const& key) const;
+
+    // Writes (*this)[keys[i]] to out[i]. Queries descend the tree in lockstep
+    // groups so their cache misses overlap; 32-bit integral keys use an AVX2
+    // gather kernel when the CPU supports it.
+    void lookup_batch(const K* keys, std::size_t n, V* out) const;
+};
+
+#include "frozen_interval_map_impl.h"
+
+#endif // FROZEN_INTERVAL_MAP_H
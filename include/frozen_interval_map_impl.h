@@ -0,0 +1,164 @@
+#ifndef FROZEN_INTERVAL_MAP_IMPL_H
+#define FROZEN_INTERVAL_MAP_IMPL_H
+
+#include "frozen_interval_map.h"
+#include "interval_map_simd.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace interval_map_detail {
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+inline unsigned trailing_ones(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return value == ~std::uint64_t(0) ? 64 : static_cast<unsigned>(__builtin_ctzll(~value));
+#else
+    unsigned count = 0;
+    while (value & 1) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+} // namespace interval_map_detail
+
+template<typename K, typename V>
+template<typename InputIt>
+frozen_interval_map<K, V>::frozen_interval_map(V const& valBegin, InputIt first, InputIt last)
+    : m_valBegin(valBegin) {
+    std::vector<K> keys;
+    std::vector<V> before;
+    std::vector<V> values;
+    for (; first != last; ++first) {
+        const auto& [key, val] = *first;
+        before.push_back(values.empty() ? m_valBegin : values.back());
+        keys.push_back(key);
+        values.push_back(val);
+    }
+    m_size = keys.size();
+
+    // Pad to a complete tree of 2^depth - 1 nodes. Padding repeats the
+    // largest key and the last value, which leaves every answer unchanged.
+    std::size_t nodes = 0;
+    while (nodes < m_size) {
+        nodes = 2 * nodes + 1;
+        ++m_depth;
+    }
+
+    V const& valLast = values.empty() ? m_valBegin : values.back();
+    m_values.assign(nodes + 1, valLast);
+    if (m_size > 0) {
+        keys.resize(nodes, keys.back());
+        before.resize(nodes, valLast);
+        m_keys.assign(nodes + 1, keys.front());
+        std::size_t rank = 0;
+        fill(keys, before, 1, rank);
+    }
+}
+
+template<typename K, typename V>
+void frozen_interval_map<K, V>::fill(std::vector<K> const& keys, std::vector<V> const& before,
+                                     std::size_t node, std::size_t& rank) {
+    if (node >= m_keys.size()) return;
+    fill(keys, before, 2 * node, rank);
+    m_keys[node] = keys[rank];
+    m_values[node] = before[rank];
+    ++rank;
+    fill(keys, before, 2 * node + 1, rank);
+}
+
+template<typename K, typename V>
+std::size_t frozen_interval_map<K, V>::size() const {
+    return m_size;
+}
+
+template<typename K, typename V>
+V const& frozen_interval_map<K, V>::get_begin_value() const {
+    return m_valBegin;
+}
+
+template<typename K, typename V>
+V const& frozen_interval_map<K, V>::operator[](K const& key) const {
+    // Descend to a leaf position, going right whenever the node key <= key.
+    // The first node with a larger key is recovered by dropping the trailing
+    // right turns plus one; an all-right path yields slot 0.
+    std::size_t node = 1;
+    for (std::size_t level = 0; level < m_depth; ++level) {
+        interval_map_detail::prefetch(m_keys.data() + 16 * node);
+        node = 2 * node + !(key < m_keys[node]);
+    }
+    return resolve(node);
+}
+
+template<typename K, typename V>
+V const& frozen_interval_map<K, V>::resolve(std::size_t node) const {
+    return m_values[node >> (interval_map_detail::trailing_ones(node) + 1)];
+}
+
+template<typename K, typename V>
+void frozen_interval_map<K, V>::lookup_batch(const K* keys, std::size_t n, V* out) const {
+    if (lookup_vectorized(keys, n, out)) return;
+    lookup_interleaved(keys, n, out);
+}
+
+template<typename K, typename V>
+void frozen_interval_map<K, V>::lookup_interleaved(const K* keys, std::size_t n, V* out) const {
+    const std::size_t GROUP = 16;
+    std::size_t nodes[GROUP];
+    for (std::size_t base = 0; base < n; base += GROUP) {
+        const std::size_t count = std::min(GROUP, n - base);
+        for (std::size_t j = 0; j < count; ++j) {
+            nodes[j] = 1;
+        }
+        for (std::size_t level = 0; level < m_depth; ++level) {
+            for (std::size_t j = 0; j < count; ++j) {
+                interval_map_detail::prefetch(m_keys.data() + 16 * nodes[j]);
+                nodes[j] = 2 * nodes[j] + !(keys[base + j] < m_keys[nodes[j]]);
+            }
+        }
+        for (std::size_t j = 0; j < count; ++j) {
+            out[base + j] = resolve(nodes[j]);
+        }
+    }
+}
+
+template<typename K, typename V>
+bool frozen_interval_map<K, V>::lookup_vectorized(const K* keys, std::size_t n, V* out) const {
+#if INTERVAL_MAP_HAVE_AVX2_KERNEL
+    if constexpr (std::is_integral_v<K> && sizeof(K) == 4) {
+        // Node indices must fit the 32-bit gather lanes
+        if (m_depth == 0 || m_depth > 30 || !interval_map_detail::has_avx2()) return false;
+
+        const std::int32_t bias = std::is_signed_v<K> ? 0 : std::numeric_limits<std::int32_t>::min();
+        const std::int32_t* tree = reinterpret_cast<const std::int32_t*>(m_keys.data());
+        const std::size_t CHUNK = 256;
+        std::uint32_t nodes[CHUNK];
+        for (std::size_t base = 0; base < n; base += CHUNK) {
+            const std::size_t count = std::min(CHUNK, n - base);
+            interval_map_detail::eytzinger_descend_avx2(tree, m_depth, bias,
+                reinterpret_cast<const std::int32_t*>(keys + base), count, nodes);
+            for (std::size_t j = 0; j < count; ++j) {
+                out[base + j] = resolve(nodes[j]);
+            }
+        }
+        return true;
+    }
+#endif
+    (void)keys;
+    (void)n;
+    (void)out;
+    return false;
+}
+
+#endif // FROZEN_INTERVAL_MAP_IMPL_H
@@ -0,0 +1,136 @@
+#ifndef INTERNED_STORAGE_H
+#define INTERNED_STORAGE_H
+
+#include "map_storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Smallest unsigned id type able to number MaxValues distinct values
+template<std::size_t MaxValues>
+using interned_id_t = std::conditional_t<(MaxValues <= 256), std::uint8_t,
+                      std::conditional_t<(MaxValues <= 65536), std::uint16_t, std::uint32_t>>;
+
+// interval_map backend for heavy value types. Each distinct value is stored
+// once in a value table, indexed by pointers into it, and boundaries hold
+// compact Id handles in a Base
+// storage (any policy instantiated as <K, Id>), so assign copies and compares
+// integers instead of values. Requires std::hash<V>. Table entries are never
+// removed, and references returned by value() stay valid for the storage's
+// lifetime. Throws std::length_error when Id runs out of values.
+template<typename K, typename V, typename Id = std::uint32_t, typename Base = map_storage<K, Id>>
+class interned_storage {
+private:
+    // Hashes and compares table entries through the pointers the index holds
+    struct entry_hash {
+        std::size_t operator()(V const* val) const { return std::hash<V>()(*val); }
+    };
+    struct entry_equal {
+        bool operator()(V const* lhs, V const* rhs) const { return *lhs == *rhs; }
+    };
+    using index_type = std::unordered_map<V const*, Id, entry_hash, entry_equal>;
+
+    Base m_base;
+    // A deque never moves its elements, so the index can point into it
+    std::deque<V> m_values;
+    index_type m_ids;
+    Id m_beginId = 0;
+
+    // Points a fresh index at this storage's own table
+    void rebuild_index() {
+        m_ids.clear();
+        m_ids.reserve(m_values.size());
+        for (std::size_t id = 0; id < m_values.size(); ++id) {
+            m_ids.emplace(&m_values[id], static_cast<Id>(id));
+        }
+    }
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using stored_type = Id;
+    using allocator_type = typename Base::allocator_type;
+    using iterator = typename Base::iterator;
+    using const_iterator = typename Base::const_iterator;
+
+    interned_storage() = default;
+    explicit interned_storage(allocator_type const& alloc) : m_base(alloc) {}
+
+    // A copy indexes its own table; moves keep the elements, and so the index
+    interned_storage(interned_storage const& other)
+        : m_base(other.m_base), m_values(other.m_values), m_beginId(other.m_beginId) {
+        rebuild_index();
+    }
+    interned_storage(interned_storage&&) = default;
+    interned_storage& operator=(interned_storage const& other) {
+        if (this != &other) {
+            m_base = other.m_base;
+            m_values = other.m_values;
+            m_beginId = other.m_beginId;
+            rebuild_index();
+        }
+        return *this;
+    }
+    interned_storage& operator=(interned_storage&&) = default;
+
+    iterator begin() { return m_base.begin(); }
+    iterator end() { return m_base.end(); }
+    const_iterator begin() const { return m_base.begin(); }
+    const_iterator end() const { return m_base.end(); }
+
+    bool empty() const { return m_base.empty(); }
+    std::size_t size() const { return m_base.size(); }
+    void clear() { m_base.clear(); }
+
+    iterator lower_bound(K const& key) { return m_base.lower_bound(key); }
+    iterator upper_bound(K const& key) { return m_base.upper_bound(key); }
+    const_iterator lower_bound(K const& key) const { return m_base.lower_bound(key); }
+    const_iterator upper_bound(K const& key) const { return m_base.upper_bound(key); }
+    const_iterator upper_bound_from(const_iterator it, K const& key) const { return m_base.upper_bound_from(it, key); }
+    iterator to_mutable(const_iterator it) { return m_base.to_mutable(it); }
+
+    std::size_t distinct_values() const { return m_values.size(); }
+
+    void bind_begin_value(V const& valBegin) { m_beginId = intern(valBegin); }
+    Id stored_begin(V const&) const { return m_beginId; }
+
+    Id intern(V const& val) {
+        auto found = m_ids.find(&val);
+        if (found != m_ids.end()) return found->second;
+        if (m_values.size() > std::numeric_limits<Id>::max()) {
+            throw std::length_error("interned_storage: too many distinct values for the id type");
+        }
+        Id id = static_cast<Id>(m_values.size());
+        m_values.push_back(val);
+        m_ids.emplace(&m_values.back(), id);
+        return id;
+    }
+
+    K const& key(const_iterator it) const { return m_base.key(it); }
+    V const& value(const_iterator it) const { return m_values[m_base.value(it)]; }
+    decltype(auto) stored(const_iterator it) const { return m_base.stored(it); }
+    void set_stored(iterator it, Id id) { m_base.set_stored(it, id); }
+
+    // Inserts a boundary that sorts immediately before hint
+    iterator insert(iterator hint, K const& key, Id id) { return m_base.insert(hint, key, id); }
+
+    iterator erase(iterator first, iterator last) { return m_base.erase(first, last); }
+
+    // Adds a boundary greater than every existing one in amortized O(1)
+    void append(K key, V const& val) { m_base.append(std::move(key), intern(val)); }
+
+    // Approximate bytes held: the boundary storage plus the value table and
+    // its hash index (heap owned by the values themselves is not counted)
+    std::size_t memory_usage() const {
+        return m_base.memory_usage() + m_values.size() * sizeof(V) + m_ids.bucket_count() * sizeof(void*) +
+               m_ids.size() * (sizeof(void*) + sizeof(typename index_type::value_type));
+    }
+};
+
+#endif // INTERNED_STORAGE_H
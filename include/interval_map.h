@@ -1,29 +1,237 @@
 #ifndef INTERVAL_MAP_H
 #define INTERVAL_MAP_H
 
-#include <map>
+#include "frozen_interval_map.h"
+#include "interval_map_stats.h"
+#include "map_storage.h"
+#include "packed_storage.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+// One entry of an assign_batch() call: assigns val to [keyBegin, keyEnd)
 template<typename K, typename V>
+struct interval_assignment {
+    K keyBegin;
+    K keyEnd;
+    V val;
+};
+
+// One maximal constant-value interval [keyBegin, keyEnd) reported by
+// interval_map::intervals(); the members refer into the map or into the
+// iterator's own copy of the query bounds, so a view lasts as long as the
+// iterator it came from and no modification intervenes
+template<typename K, typename V>
+struct interval_view {
+    K const& keyBegin;
+    K const& keyEnd;
+    V const& val;
+};
+
+// Storage used when none is named: packed_storage for small trivially
+// copyable keys and values, map_storage otherwise
+template<typename K, typename V>
+using default_storage_t = std::conditional_t<is_packable_v<K, V>, packed_storage<K, V>, map_storage<K, V>>;
+
+namespace interval_map_detail {
+// Change callback of the plain assigns; reporting compiles away for it
+struct no_observer {};
+
+// Process-unique number identifying one map object. A copy draws a new one,
+// so a map built where another was destroyed never inherits its identity.
+class instance_id {
+private:
+    std::uint64_t m_value = next();
+
+    static std::uint64_t next() {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+public:
+    instance_id() = default;
+    instance_id(instance_id const&) : m_value(next()) {}
+    instance_id& operator=(instance_id const&) { return *this; }
+
+    std::uint64_t value() const { return m_value; }
+};
+} // namespace interval_map_detail
+
+// Storage is the boundary container policy; map_storage, packed_storage,
+// flat_storage, interned_storage and augmented_storage are provided. A policy
+// exposes sorted (key, value) boundaries through iterators with begin/end,
+// lower_bound/upper_bound, key/value accessors, hinted insert and range
+// erase. Values may be kept in a cheaper stored form (stored_type, e.g. an
+// interned id): assign compares and writes stored forms obtained through
+// intern() and stored_begin().
+template<typename K, typename V, typename Storage = default_storage_t<K, V>>
 class interval_map {
 private:
     V m_valBegin;
-    std::map<K,V> m_map;
+#ifdef INTERVAL_MAP_STATS
+    mutable interval_map_detail::stats_recorder m_stats;
+#else
+    // The disabled recorder has no state; a static one keeps it out of
+    // every map's layout
+    static constexpr interval_map_detail::stats_recorder m_stats{};
+#endif
+    // Bumped by every modification; a finger is only trusted by the map
+    // instance it came from, at its epoch
+    std::uint64_t m_epoch = 0;
+    interval_map_detail::instance_id m_id;
+    Storage m_storage;
 
     bool is_valid_interval(K const& keyBegin, K const& keyEnd) const;
-    void canonicalize();
+    void assign_unrecorded(K const& keyBegin, K const& keyEnd, V const& val);
+    template<typename Observer>
+    typename Storage::iterator assign_before(typename Storage::iterator last, K const& keyBegin, K const& keyEnd,
+                                             V const& val, bool fromEnd, Observer& onChange);
+
+    struct segment {
+        K const* keyBegin;
+        K const* keyEnd;
+        V const* val;
+    };
+    template<typename Range>
+    static std::vector<segment> resolve_batch(Range const& batch);
+    void merge_segments(std::vector<segment> const& segments);
 
 public:
+    using storage_type = Storage;
+
+    // Answers lookups for a non-decreasing key sequence by advancing through
+    // the boundaries instead of searching from scratch. Invalidated by any
+    // modification of the map.
+    class sorted_cursor {
+    private:
+        interval_map const* m_map;
+        typename Storage::const_iterator m_next;
+
+    public:
+        explicit sorted_cursor(interval_map const& map);
+        V const& seek(K const& key);
+    };
+
+    // Remembers where the last hinted lookup or assign left off, so the next
+    // one near it steps a few boundaries instead of searching the whole map.
+    // A finger left stale by another modification, or taken from another
+    // map (including a destroyed one at the same address), is ignored and the
+    // operation falls back to a full search.
+    class finger {
+    private:
+        friend class interval_map;
+        std::uint64_t m_owner = 0;
+        std::uint64_t m_epoch = 0;
+        typename Storage::const_iterator m_next{};
+    };
+
+    // Forward iterator over the intervals overlapping a query range, clipped
+    // to it; holds its own copy of the query bounds. Invalidated by any
+    // modification of the map.
+    class interval_iterator {
+    private:
+        interval_map const* m_map = nullptr;
+        typename Storage::const_iterator m_next{};
+        K m_queryBegin{};
+        K m_queryEnd{};
+        // Boundary opening the current interval; null while at the first one
+        K const* m_keyBegin = nullptr;
+        V const* m_val = nullptr;
+
+        bool ends_at_query_end() const;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = interval_view<K, V>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = interval_view<K, V>;
+
+        interval_iterator() = default;
+        interval_iterator(interval_map const& map, K const& keyBegin, K const& keyEnd);
+
+        interval_view<K, V> operator*() const;
+        interval_iterator& operator++();
+        interval_iterator operator++(int);
+        bool operator==(interval_iterator const& other) const;
+        bool operator!=(interval_iterator const& other) const;
+    };
+
+    class interval_range {
+    private:
+        interval_iterator m_begin;
+
+    public:
+        explicit interval_range(interval_iterator begin) : m_begin(begin) {}
+        interval_iterator begin() const { return m_begin; }
+        interval_iterator end() const { return interval_iterator(); }
+    };
+
     interval_map(V const& val);
+    // Allocator-aware construction; for pmr_interval_map a memory_resource*
+    // converts implicitly
+    interval_map(V const& val, typename Storage::allocator_type const& alloc);
     interval_map& operator=(interval_map const&) = delete;
+
+    // Builds a map in O(n) from (key, value) boundaries with strictly
+    // increasing keys; boundaries that repeat the value in effect are dropped.
+    // Throws std::invalid_argument on out-of-order keys.
+    template<typename ForwardIt>
+    static interval_map from_sorted(V const& valBegin, ForwardIt first, ForwardIt last);
     
-    const std::map<K,V>& get_map() const;
+    const Storage& get_storage() const;
+    std::size_t size() const;
     V const& get_begin_value() const;
 
     void assign(K const& keyBegin, K const& keyEnd, V const& val);
+    // Same as assign(keyBegin, keyEnd, val), first calling onChange(begin,
+    // end, oldVal, val) for each maximal range whose value changes, in key
+    // order; an assign that changes nothing reports nothing. The arguments
+    // refer into the map or the call and must not be kept; onChange must not
+    // modify the map.
+    template<typename F>
+    void assign(K const& keyBegin, K const& keyEnd, V const& val, F&& onChange);
+    // Same result as assign(keyBegin, keyEnd, val) and operator[](key),
+    // starting from hint and leaving it at the touched boundaries
+    void assign(finger& hint, K const& keyBegin, K const& keyEnd, V const& val);
+    V const& lookup(finger& hint, K const& key) const;
+    // Same result as assigning every element of batch in order (elements
+    // expose keyBegin, keyEnd and val, see interval_assignment)
+    template<typename Range>
+    void assign_batch(Range const& batch);
     V const& operator[](K const& key) const;
+    void lookup_batch(const K* keys, std::size_t n, V* out) const;
+    template<typename InputIt, typename OutputIt>
+    OutputIt lookup_sorted(InputIt first, InputIt last, OutputIt out) const;
+
+    // Intervals overlapping [keyBegin, keyEnd), clipped to it, in O(log n + k)
+    // copying nothing but the two bounds
+    interval_range intervals(K const& keyBegin, K const& keyEnd) const;
+    // Calls f(begin, end, val) for each interval of intervals(keyBegin, keyEnd)
+    template<typename F>
+    void for_each_interval(K const& keyBegin, K const& keyEnd, F&& f) const;
     void clear();
+
+    frozen_interval_map<K, V> freeze() const;
+
+    // Operation counters and sampled latencies; all zero unless built with
+    // INTERVAL_MAP_STATS (see interval_map_stats)
+    interval_map_stats stats() const;
+    void reset_stats();
+
+private:
+    typename Storage::const_iterator seek_from(finger const& hint, K const& key) const;
 };
 
+// interval_map whose boundary nodes come from a std::pmr::memory_resource
+template<typename K, typename V>
+using pmr_interval_map = interval_map<K, V, map_storage<K, V, std::pmr::polymorphic_allocator<std::pair<const K, V>>>>;
+
 #include "interval_map_impl.h"
 
 #endif // INTERVAL_MAP_H
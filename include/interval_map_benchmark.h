@@ -0,0 +1,60 @@
+#ifndef INTERVAL_MAP_BENCHMARK_H
+#define INTERVAL_MAP_BENCHMARK_H
+
+#include "interval_map.h"
+#include "flat_storage.h"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+class IntervalMapBenchmark {
+private:
+    static std::mt19937 gen;
+
+    // Assignment Benchmarks
+    static void bench_assign_scaling();
+    static void bench_batch_assign();
+    static void bench_buffered_writes();
+    static void bench_persistent_versions();
+    static void bench_combine();
+    static void bench_interned_assign();
+    static void bench_change_feed();
+
+    // Construction Benchmarks
+    static void bench_from_sorted();
+    static void bench_snapshot_load();
+    static void bench_wal_replay();
+    static void bench_delimited_ingest();
+
+    // Allocation Benchmarks
+    static void bench_allocation_churn();
+    static void bench_memory_footprint();
+
+    // Lookup Benchmarks
+    static void bench_lookup_backends();
+    static void bench_batch_lookup();
+    static void bench_sorted_lookup();
+    static void bench_finger_locality();
+    static void bench_range_report();
+
+    // Concurrency Benchmarks
+    static void bench_concurrent_reads();
+    static void bench_sharded_writes();
+    static void bench_parallel_scaling();
+
+    // Helper Methods
+    static int random_key(int min, int max);
+    template<typename Storage>
+    static void build_alternating(interval_map<int, char, Storage>& imap, size_t boundaries);
+    template<typename Map>
+    static double time_heavy_assigns(Map& imap, const std::vector<std::string>& values, size_t boundaries);
+    template<typename Map>
+    static double time_lookups(const Map& imap, const std::vector<int>& keys);
+    static void print_result(const std::string& name, size_t boundaries, double ns_per_op);
+
+public:
+    static void run_all_benchmarks();
+};
+
+#endif // INTERVAL_MAP_BENCHMARK_H
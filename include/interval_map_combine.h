@@ -0,0 +1,29 @@
+#ifndef INTERVAL_MAP_COMBINE_H
+#define INTERVAL_MAP_COMBINE_H
+
+#include "interval_map.h"
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+template<typename F, typename VA, typename VB>
+using combine_result_t = std::decay_t<std::invoke_result_t<F&, VA const&, VB const&>>;
+
+// Map with result[key] == f(a[key], b[key]) for every key, built by one merge
+// walk over both boundary sets in O(n + m) calls of f and emitted in
+// canonical form. Replaces overlaying b onto a one assign at a time.
+template<typename K, typename VA, typename SA, typename VB, typename SB, typename F>
+interval_map<K, combine_result_t<F, VA, VB>> combine(interval_map<K, VA, SA> const& a,
+                                                     interval_map<K, VB, SB> const& b, F f);
+
+// Same result, with the key range split at boundary quantiles and the pieces
+// walked on up to threads threads. f is copied into each, must be safe to
+// call concurrently and must not throw. The final canonical build stays
+// sequential.
+template<typename K, typename VA, typename SA, typename VB, typename SB, typename F>
+interval_map<K, combine_result_t<F, VA, VB>> combine(interval_map<K, VA, SA> const& a,
+                                                     interval_map<K, VB, SB> const& b, F f, std::size_t threads);
+
+#include "interval_map_combine_impl.h"
+
+#endif // INTERVAL_MAP_COMBINE_H
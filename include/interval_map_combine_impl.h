@@ -0,0 +1,119 @@
+#ifndef INTERVAL_MAP_COMBINE_IMPL_H
+#define INTERVAL_MAP_COMBINE_IMPL_H
+
+#include "interval_map_combine.h"
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace interval_map_detail {
+
+// Appends the boundaries of f(a, b) inside [lo, hi) to out; a null bound is
+// unbounded. A bounded piece always opens with a boundary at lo so pieces
+// concatenate; from_sorted drops it if it repeats the previous piece.
+template<typename K, typename VA, typename SA, typename VB, typename SB, typename F, typename R>
+void combine_walk(interval_map<K, VA, SA> const& a, interval_map<K, VB, SB> const& b, F& f,
+                  K const* lo, K const* hi, std::vector<std::pair<K, R>>& out) {
+    auto const& sa = a.get_storage();
+    auto const& sb = b.get_storage();
+    auto ia = lo ? sa.upper_bound(*lo) : sa.begin();
+    auto ib = lo ? sb.upper_bound(*lo) : sb.begin();
+    VA const* va = lo ? &a[*lo] : &a.get_begin_value();
+    VB const* vb = lo ? &b[*lo] : &b.get_begin_value();
+
+    R current = f(*va, *vb);
+    if (lo) {
+        out.emplace_back(*lo, current);
+    }
+    for (;;) {
+        bool moreA = ia != sa.end() && (!hi || sa.key(ia) < *hi);
+        bool moreB = ib != sb.end() && (!hi || sb.key(ib) < *hi);
+        if (!moreA && !moreB) break;
+
+        // Take the smaller next boundary, or both when they coincide
+        bool takeA = moreA && (!moreB || !(sb.key(ib) < sa.key(ia)));
+        bool takeB = moreB && (!moreA || !(sa.key(ia) < sb.key(ib)));
+        K const& key = takeA ? sa.key(ia) : sb.key(ib);
+        if (takeA) va = &sa.value(ia);
+        if (takeB) vb = &sb.value(ib);
+
+        R next = f(*va, *vb);
+        if (!(next == current)) {
+            out.emplace_back(key, next);
+            current = std::move(next);
+        }
+        if (takeA) ++ia;
+        if (takeB) ++ib;
+    }
+}
+
+} // namespace interval_map_detail
+
+template<typename K, typename VA, typename SA, typename VB, typename SB, typename F>
+interval_map<K, combine_result_t<F, VA, VB>> combine(interval_map<K, VA, SA> const& a,
+                                                     interval_map<K, VB, SB> const& b, F f) {
+    using R = combine_result_t<F, VA, VB>;
+    std::vector<std::pair<K, R>> boundaries;
+    boundaries.reserve(a.size() + b.size());
+    interval_map_detail::combine_walk(a, b, f, static_cast<K const*>(nullptr), static_cast<K const*>(nullptr),
+                                      boundaries);
+    return interval_map<K, R>::from_sorted(f(a.get_begin_value(), b.get_begin_value()), boundaries.begin(),
+                                           boundaries.end());
+}
+
+template<typename K, typename VA, typename SA, typename VB, typename SB, typename F>
+interval_map<K, combine_result_t<F, VA, VB>> combine(interval_map<K, VA, SA> const& a,
+                                                     interval_map<K, VB, SB> const& b, F f, std::size_t threads) {
+    using R = combine_result_t<F, VA, VB>;
+    // Splitting pays for a thread only with a good amount of work per piece
+    constexpr std::size_t min_piece = 1 << 16;
+    std::size_t total = a.size() + b.size();
+    std::size_t pieces = std::min(threads, total / min_piece);
+    if (pieces <= 1) {
+        return combine(a, b, std::move(f));
+    }
+
+    // Quantiles of the larger boundary set keep the pieces roughly even
+    std::vector<K> splitters;
+    auto pick = [&](auto const& storage) {
+        std::size_t stride = storage.size() / pieces;
+        std::size_t rank = 0;
+        for (auto it = storage.begin(); it != storage.end() && splitters.size() + 1 < pieces; ++it, ++rank) {
+            if (rank > 0 && rank % stride == 0) splitters.push_back(storage.key(it));
+        }
+    };
+    if (a.size() >= b.size()) {
+        pick(a.get_storage());
+    } else {
+        pick(b.get_storage());
+    }
+
+    std::vector<std::vector<std::pair<K, R>>> parts(splitters.size() + 1);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        K const* lo = i == 0 ? nullptr : &splitters[i - 1];
+        K const* hi = i == splitters.size() ? nullptr : &splitters[i];
+        workers.emplace_back([&a, &b, f, lo, hi, &part = parts[i]]() mutable {
+            interval_map_detail::combine_walk(a, b, f, lo, hi, part);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<std::pair<K, R>> boundaries;
+    std::size_t count = 0;
+    for (auto const& part : parts) {
+        count += part.size();
+    }
+    boundaries.reserve(count);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(boundaries));
+    }
+    return interval_map<K, R>::from_sorted(f(a.get_begin_value(), b.get_begin_value()), boundaries.begin(),
+                                           boundaries.end());
+}
+
+#endif // INTERVAL_MAP_COMBINE_IMPL_H
@@ -4,70 +4,505 @@
 #include "interval_map.h"
 #include <cassert>
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-template<typename K, typename V>
-interval_map<K, V>::interval_map(V const& val) : m_valBegin(val) {}
+namespace interval_map_detail {
 
-template<typename K, typename V>
-const std::map<K, V>& interval_map<K, V>::get_map() const {
-    return m_map;
+// Batch endpoints are sorted by value when keys are cheap to copy, so the
+// comparisons stay in cache instead of chasing pointers into the batch
+template<typename K>
+constexpr bool sort_keys_by_value = std::is_trivially_copyable_v<K> && sizeof(K) <= 16;
+
+template<typename K>
+using batch_sort_key = std::conditional_t<sort_keys_by_value<K>, K, K const*>;
+
+template<typename K>
+batch_sort_key<K> make_sort_key(K const& key) {
+    if constexpr (sort_keys_by_value<K>) {
+        return key;
+    } else {
+        return &key;
+    }
+}
+
+template<typename K>
+K const& sort_key_value(batch_sort_key<K> const& key) {
+    if constexpr (sort_keys_by_value<K>) {
+        return key;
+    } else {
+        return *key;
+    }
+}
+
+} // namespace interval_map_detail
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage>::interval_map(V const& val) : m_valBegin(val) {
+    m_storage.bind_begin_value(m_valBegin);
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage>::interval_map(V const& val, typename Storage::allocator_type const& alloc)
+    : m_valBegin(val), m_storage(alloc) {
+    m_storage.bind_begin_value(m_valBegin);
 }
 
-template<typename K, typename V>
-V const& interval_map<K, V>::get_begin_value() const {
+template<typename K, typename V, typename Storage>
+template<typename ForwardIt>
+interval_map<K, V, Storage> interval_map<K, V, Storage>::from_sorted(V const& valBegin, ForwardIt first, ForwardIt last) {
+    interval_map result(valBegin);
+    Storage& storage = result.m_storage;
+    for (ForwardIt prev = last; first != last; prev = first++) {
+        const auto& [key, val] = *first;
+        if (prev != last && !((*prev).first < key)) {
+            throw std::invalid_argument("interval_map::from_sorted: keys must be strictly increasing");
+        }
+        V const& valCurrent = storage.empty() ? result.m_valBegin : storage.value(std::prev(storage.end()));
+        if (!(valCurrent == val)) {
+            storage.append(key, val);
+        }
+    }
+    return result;
+}
+
+template<typename K, typename V, typename Storage>
+const Storage& interval_map<K, V, Storage>::get_storage() const {
+    return m_storage;
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t interval_map<K, V, Storage>::size() const {
+    return m_storage.size();
+}
+
+template<typename K, typename V, typename Storage>
+V const& interval_map<K, V, Storage>::get_begin_value() const {
     return m_valBegin;
 }
 
-template<typename K, typename V>
-bool interval_map<K, V>::is_valid_interval(K const& keyBegin, K const& keyEnd) const {
+template<typename K, typename V, typename Storage>
+bool interval_map<K, V, Storage>::is_valid_interval(K const& keyBegin, K const& keyEnd) const {
     return keyBegin < keyEnd;
 }
 
-template<typename K, typename V>
-void interval_map<K, V>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    auto timer = m_stats.time_assign();
+    assign_unrecorded(keyBegin, keyEnd, val);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::assign(finger& hint, K const& keyBegin, K const& keyEnd, V const& val) {
+    auto timer = m_stats.time_assign();
+    if (!is_valid_interval(keyBegin, keyEnd)) return;
+    interval_map_detail::no_observer none;
+    auto next = assign_before(m_storage.to_mutable(seek_from(hint, keyEnd)), keyBegin, keyEnd, val, true, none);
+    hint.m_owner = m_id.value();
+    hint.m_epoch = m_epoch;
+    hint.m_next = next;
+}
+
+template<typename K, typename V, typename Storage>
+template<typename F>
+void interval_map<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val, F&& onChange) {
+    auto timer = m_stats.time_assign();
+    if (!is_valid_interval(keyBegin, keyEnd)) return;
+    assign_before(m_storage.upper_bound(keyEnd), keyBegin, keyEnd, val, false, onChange);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::assign_unrecorded(K const& keyBegin, K const& keyEnd, V const& val) {
     if (!is_valid_interval(keyBegin, keyEnd)) return;
+    interval_map_detail::no_observer none;
+    assign_before(m_storage.upper_bound(keyEnd), keyBegin, keyEnd, val, false, none);
+}
+
+// Assigns val to a valid [keyBegin, keyEnd) given last == upper_bound(keyEnd).
+// With fromEnd the left edge is found by stepping back from the right one,
+// which beats a search when the interval spans few boundaries. Returns
+// upper_bound(keyBegin) of the result.
+template<typename K, typename V, typename Storage>
+template<typename Observer>
+typename Storage::iterator interval_map<K, V, Storage>::assign_before(typename Storage::iterator last, K const& keyBegin,
+                                                                      K const& keyEnd, V const& val, bool fromEnd,
+                                                                      Observer& onChange) {
+    ++m_epoch;
+
+    // Work on the storage's own value form so merges compare cheap ids when
+    // the storage interns values
+    decltype(auto) stored = m_storage.intern(val);
+    decltype(auto) storedBegin = m_storage.stored_begin(m_valBegin);
 
-    auto afterEnd = m_map.upper_bound(keyEnd);
-    V valueAfter = (afterEnd == m_map.begin()) ? m_valBegin : (--afterEnd)->second;
+    // Right edge: keep (or create) a boundary at keyEnd restoring the value
+    // that was in effect there, unless it equals val and the two merge.
+    auto const& storedEnd = (last == m_storage.begin()) ? storedBegin : m_storage.stored(std::prev(last));
+    if (!(storedEnd == stored)) {
+        if (last != m_storage.begin() && !(m_storage.key(std::prev(last)) < keyEnd)) {
+            --last;
+        } else {
+            last = m_storage.insert(last, keyEnd, storedEnd);
+            m_stats.inserted(1);
+        }
+    } else {
+        m_stats.merged();
+    }
 
-    m_map[keyBegin] = val;
-    m_map[keyEnd] = valueAfter;
+    // Left edge: only a value change at keyBegin needs a boundary.
+    auto first = last;
+    if (fromEnd) {
+        while (first != m_storage.begin() && !(m_storage.key(std::prev(first)) < keyBegin)) {
+            --first;
+        }
+    } else {
+        first = m_storage.lower_bound(keyBegin);
+    }
+    auto const& storedBefore = (first == m_storage.begin()) ? storedBegin : m_storage.stored(std::prev(first));
 
-    auto it = m_map.upper_bound(keyBegin);
-    while (it != m_map.end() && it->first < keyEnd) {
-        it = m_map.erase(it);
+    // [first, last) still holds every old boundary inside the interval;
+    // canonical form makes each old value run between them maximal
+    if constexpr (!std::is_same_v<Observer, interval_map_detail::no_observer>) {
+        auto it = first;
+        K const* runBegin = &keyBegin;
+        V const* runVal = &m_valBegin;
+        if (it != last && !(keyBegin < m_storage.key(it))) {
+            runVal = &m_storage.value(it++);
+        } else if (it != m_storage.begin()) {
+            runVal = &m_storage.value(std::prev(it));
+        }
+        for (; it != last && m_storage.key(it) < keyEnd; ++it) {
+            if (!(*runVal == val)) onChange(*runBegin, m_storage.key(it), *runVal, val);
+            runBegin = &m_storage.key(it);
+            runVal = &m_storage.value(it);
+        }
+        if (!(*runVal == val)) onChange(*runBegin, keyEnd, *runVal, val);
     }
 
-    canonicalize();
+    typename Storage::iterator next;
+    if (storedBefore == stored) {
+        m_stats.merged();
+        m_stats.erased(first, last);
+        next = m_storage.erase(first, last);
+    } else if (first != last && !(keyBegin < m_storage.key(first))) {
+        m_storage.set_stored(first, stored);
+        m_stats.erased(std::next(first), last);
+        next = m_storage.erase(std::next(first), last);
+    } else {
+        // Insert before erasing so val may still alias a boundary being dropped
+        auto count = std::distance(first, last);
+        first = m_storage.insert(first, keyBegin, stored);
+        next = m_storage.erase(std::next(first), std::next(first, count + 1));
+        m_stats.inserted(1);
+        m_stats.erased(static_cast<std::uint64_t>(count));
+    }
+    m_stats.observe_size(m_storage.size());
+    return next;
 }
 
-template<typename K, typename V>
-V const& interval_map<K, V>::operator[](K const& key) const {
-    auto it = m_map.upper_bound(key);
-    return (it == m_map.begin()) ? m_valBegin : (--it)->second;
+template<typename K, typename V, typename Storage>
+template<typename Range>
+void interval_map<K, V, Storage>::assign_batch(Range const& batch) {
+    m_stats.count_assigns(batch);
+    std::vector<segment> segments = resolve_batch(batch);
+    if (segments.empty()) return;
+
+    // A few segments are cheaper to assign one by one than to rewrite every
+    // boundary; large batches are merged in a single linear pass.
+    std::size_t depth = 1;
+    for (std::size_t n = m_storage.size(); n > 0; n >>= 1) {
+        ++depth;
+    }
+    if (segments.size() * depth < m_storage.size()) {
+        for (segment const& seg : segments) {
+            assign_unrecorded(*seg.keyBegin, *seg.keyEnd, *seg.val);
+        }
+    } else {
+        merge_segments(segments);
+    }
 }
 
-template<typename K, typename V>
-void interval_map<K, V>::clear() {
-    m_map.clear();
+template<typename K, typename V, typename Storage>
+template<typename Range>
+std::vector<typename interval_map<K, V, Storage>::segment>
+interval_map<K, V, Storage>::resolve_batch(Range const& batch) {
+    using namespace interval_map_detail;
+    struct endpoint {
+        batch_sort_key<K> key;
+        K const* where;
+        std::size_t entry;
+    };
+
+    // Later entries win, so index order doubles as write priority
+    using entry_pointer = decltype(&*std::begin(batch));
+    std::vector<entry_pointer> entries;
+    std::vector<endpoint> begins;
+    std::vector<endpoint> ends;
+    for (auto const& entry : batch) {
+        if (!(entry.keyBegin < entry.keyEnd)) continue;
+        begins.push_back({make_sort_key(entry.keyBegin), &entry.keyBegin, entries.size()});
+        ends.push_back({make_sort_key(entry.keyEnd), &entry.keyEnd, entries.size()});
+        entries.push_back(&entry);
+    }
+
+    auto key_less = [](endpoint const& a, endpoint const& b) {
+        return sort_key_value<K>(a.key) < sort_key_value<K>(b.key);
+    };
+    std::sort(begins.begin(), begins.end(), key_less);
+    std::sort(ends.begin(), ends.end(), key_less);
+
+    // Every distinct endpoint key, in order
+    std::vector<endpoint> points;
+    points.reserve(begins.size() + ends.size());
+    std::merge(begins.begin(), begins.end(), ends.begin(), ends.end(), std::back_inserter(points), key_less);
+    points.erase(std::unique(points.begin(), points.end(),
+                             [&](endpoint const& a, endpoint const& b) { return !key_less(a, b) && !key_less(b, a); }),
+                 points.end());
+
+    // Sweep the elementary segments between consecutive endpoints, keeping
+    // the covering entries in a max-heap by index; expired entries are
+    // dropped lazily once they surface.
+    struct covering {
+        std::size_t entry;
+        batch_sort_key<K> end;
+        bool operator<(covering const& other) const { return entry < other.entry; }
+    };
+    std::vector<segment> segments;
+    std::priority_queue<covering> active;
+    std::size_t next = 0;
+    for (std::size_t p = 0; p + 1 < points.size(); ++p) {
+        K const& x = sort_key_value<K>(points[p].key);
+        while (next < begins.size() && !(x < sort_key_value<K>(begins[next].key))) {
+            std::size_t entry = begins[next++].entry;
+            active.push({entry, make_sort_key(entries[entry]->keyEnd)});
+        }
+        while (!active.empty() && !(x < sort_key_value<K>(active.top().end))) {
+            active.pop();
+        }
+        if (active.empty()) continue;
+
+        V const& val = entries[active.top().entry]->val;
+        if (!segments.empty() && !(*segments.back().keyEnd < x) && *segments.back().val == val) {
+            segments.back().keyEnd = points[p + 1].where;
+        } else {
+            segments.push_back({points[p].where, points[p + 1].where, &val});
+        }
+    }
+    return segments;
 }
 
-template<typename K, typename V>
-void interval_map<K, V>::canonicalize() {
-    if (m_map.empty()) return;
-    
-    auto it = m_map.begin();
-    V prevVal = it->second;
-    ++it;
-    
-    while (it != m_map.end()) {
-        if (it->second == prevVal) {
-            it = m_map.erase(it);
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::merge_segments(std::vector<segment> const& segments) {
+    std::vector<std::pair<K, V>> merged;
+    merged.reserve(m_storage.size() + 2 * segments.size());
+
+    // Appends a boundary, letting a later one at the same key win and
+    // dropping any that repeats the value already in effect
+    auto emit = [&](K const& key, V const& val) {
+        if (!merged.empty() && !(merged.back().first < key)) {
+            merged.pop_back();
+        }
+        V const& prev = merged.empty() ? m_valBegin : merged.back().second;
+        if (!(prev == val)) {
+            merged.emplace_back(key, val);
         } else {
-            prevVal = it->second;
-            ++it;
+            m_stats.merged();
+        }
+    };
+
+    auto it = m_storage.begin();
+    V const* valBase = &m_valBegin;
+    for (segment const& seg : segments) {
+        for (; it != m_storage.end() && m_storage.key(it) < *seg.keyBegin; ++it) {
+            valBase = &m_storage.value(it);
+            emit(m_storage.key(it), *valBase);
         }
+        emit(*seg.keyBegin, *seg.val);
+        for (; it != m_storage.end() && !(*seg.keyEnd < m_storage.key(it)); ++it) {
+            valBase = &m_storage.value(it);
+        }
+        emit(*seg.keyEnd, *valBase);
+    }
+    for (; it != m_storage.end(); ++it) {
+        emit(m_storage.key(it), m_storage.value(it));
+    }
+
+    // A rebuild replaces every boundary
+    ++m_epoch;
+    m_stats.erased(m_storage.size());
+    m_stats.inserted(merged.size());
+    m_storage.clear();
+    for (auto& [key, val] : merged) {
+        m_storage.append(std::move(key), std::move(val));
     }
+    m_stats.observe_size(m_storage.size());
+}
+
+template<typename K, typename V, typename Storage>
+V const& interval_map<K, V, Storage>::operator[](K const& key) const {
+    auto timer = m_stats.time_lookup();
+    auto it = m_storage.upper_bound(key);
+    return (it == m_storage.begin()) ? m_valBegin : m_storage.value(std::prev(it));
+}
+
+template<typename K, typename V, typename Storage>
+V const& interval_map<K, V, Storage>::lookup(finger& hint, K const& key) const {
+    auto timer = m_stats.time_lookup();
+    auto it = seek_from(hint, key);
+    hint.m_owner = m_id.value();
+    hint.m_epoch = m_epoch;
+    hint.m_next = it;
+    return (it == m_storage.begin()) ? m_valBegin : m_storage.value(std::prev(it));
+}
+
+// upper_bound(key), walking at most finger_reach boundaries from a valid
+// hint before giving up and searching from the root
+template<typename K, typename V, typename Storage>
+typename Storage::const_iterator interval_map<K, V, Storage>::seek_from(finger const& hint, K const& key) const {
+    constexpr int finger_reach = 4;
+    if (hint.m_owner == m_id.value() && hint.m_epoch == m_epoch) {
+        auto it = hint.m_next;
+        for (int step = 0;; ++step) {
+            bool right = it != m_storage.end() && !(key < m_storage.key(it));
+            bool left = !right && it != m_storage.begin() && key < m_storage.key(std::prev(it));
+            if (!right && !left) return it;
+            if (step == finger_reach) break;
+            if (right) {
+                ++it;
+            } else {
+                --it;
+            }
+        }
+    }
+    return m_storage.upper_bound(key);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::lookup_batch(const K* keys, std::size_t n, V* out) const {
+    // Tree and array backends offer nothing to vectorize; freeze() the map
+    // for the interleaved and SIMD batch kernels.
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = (*this)[keys[i]];
+    }
+}
+
+template<typename K, typename V, typename Storage>
+template<typename InputIt, typename OutputIt>
+OutputIt interval_map<K, V, Storage>::lookup_sorted(InputIt first, InputIt last, OutputIt out) const {
+    sorted_cursor cursor(*this);
+    for (; first != last; ++first) {
+        *out++ = cursor.seek(*first);
+    }
+    return out;
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage>::sorted_cursor::sorted_cursor(interval_map const& map)
+    : m_map(&map), m_next(map.m_storage.begin()) {}
+
+template<typename K, typename V, typename Storage>
+V const& interval_map<K, V, Storage>::sorted_cursor::seek(K const& key) {
+    auto timer = m_map->m_stats.time_lookup();
+    Storage const& storage = m_map->m_storage;
+    m_next = storage.upper_bound_from(m_next, key);
+    return (m_next == storage.begin()) ? m_map->m_valBegin : storage.value(std::prev(m_next));
+}
+
+template<typename K, typename V, typename Storage>
+typename interval_map<K, V, Storage>::interval_range
+interval_map<K, V, Storage>::intervals(K const& keyBegin, K const& keyEnd) const {
+    if (!is_valid_interval(keyBegin, keyEnd)) return interval_range(interval_iterator());
+    return interval_range(interval_iterator(*this, keyBegin, keyEnd));
+}
+
+template<typename K, typename V, typename Storage>
+template<typename F>
+void interval_map<K, V, Storage>::for_each_interval(K const& keyBegin, K const& keyEnd, F&& f) const {
+    for (interval_view<K, V> interval : intervals(keyBegin, keyEnd)) {
+        f(interval.keyBegin, interval.keyEnd, interval.val);
+    }
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage>::interval_iterator::interval_iterator(interval_map const& map, K const& keyBegin, K const& keyEnd)
+    : m_map(&map), m_next(map.m_storage.upper_bound(keyBegin)), m_queryBegin(keyBegin), m_queryEnd(keyEnd),
+      m_val(m_next == map.m_storage.begin() ? &map.m_valBegin : &map.m_storage.value(std::prev(m_next))) {}
+
+template<typename K, typename V, typename Storage>
+bool interval_map<K, V, Storage>::interval_iterator::ends_at_query_end() const {
+    Storage const& storage = m_map->m_storage;
+    return m_next == storage.end() || !(storage.key(m_next) < m_queryEnd);
+}
+
+template<typename K, typename V, typename Storage>
+interval_view<K, V> interval_map<K, V, Storage>::interval_iterator::operator*() const {
+    return {m_keyBegin ? *m_keyBegin : m_queryBegin, ends_at_query_end() ? m_queryEnd : m_map->m_storage.key(m_next),
+            *m_val};
+}
+
+template<typename K, typename V, typename Storage>
+typename interval_map<K, V, Storage>::interval_iterator&
+interval_map<K, V, Storage>::interval_iterator::operator++() {
+    if (ends_at_query_end()) {
+        *this = interval_iterator();
+        return *this;
+    }
+    Storage const& storage = m_map->m_storage;
+    m_keyBegin = &storage.key(m_next);
+    m_val = &storage.value(m_next);
+    ++m_next;
+    return *this;
+}
+
+template<typename K, typename V, typename Storage>
+typename interval_map<K, V, Storage>::interval_iterator
+interval_map<K, V, Storage>::interval_iterator::operator++(int) {
+    interval_iterator tmp = *this;
+    ++*this;
+    return tmp;
+}
+
+template<typename K, typename V, typename Storage>
+bool interval_map<K, V, Storage>::interval_iterator::operator==(interval_iterator const& other) const {
+    // Intervals are identified by the boundary after them; the end iterator has no map
+    return m_map == other.m_map && (m_map == nullptr || m_next == other.m_next);
+}
+
+template<typename K, typename V, typename Storage>
+bool interval_map<K, V, Storage>::interval_iterator::operator!=(interval_iterator const& other) const {
+    return !(*this == other);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::clear() {
+    ++m_epoch;
+    m_storage.clear();
+}
+
+template<typename K, typename V, typename Storage>
+frozen_interval_map<K, V> interval_map<K, V, Storage>::freeze() const {
+    // Read through the accessors: iterators of an interning storage yield
+    // stored ids rather than values
+    std::vector<std::pair<K, V>> boundaries;
+    boundaries.reserve(m_storage.size());
+    for (auto it = m_storage.begin(); it != m_storage.end(); ++it) {
+        boundaries.emplace_back(m_storage.key(it), m_storage.value(it));
+    }
+    return frozen_interval_map<K, V>(m_valBegin, boundaries.begin(), boundaries.end());
+}
+
+template<typename K, typename V, typename Storage>
+interval_map_stats interval_map<K, V, Storage>::stats() const {
+    return m_stats.snapshot();
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map<K, V, Storage>::reset_stats() {
+    m_stats.reset();
 }
 
 #endif // INTERVAL_MAP_IMPL_H
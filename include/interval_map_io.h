@@ -0,0 +1,126 @@
+#ifndef INTERVAL_MAP_IO_H
+#define INTERVAL_MAP_IO_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+// Reads a delimited text file one line at a time without allocating per
+// line: either through one reused buffer refilled chunk by chunk, or by
+// mapping the whole file. "-" reads standard input (never mapped). Lines
+// are handed out without their terminator ("\n" or "\r\n") and stay valid
+// until the next call. Throws std::system_error on I/O failure.
+class line_reader {
+private:
+    int m_fd = -1;
+    bool m_ownsFd = false;
+    void* m_mapping = nullptr;
+    std::size_t m_mappingLength = 0;
+    std::vector<char> m_buffer;
+    char const* m_next = nullptr;      // first unread byte
+    char const* m_end = nullptr;       // end of the bytes read so far
+    bool m_eof = false;
+    std::uint64_t m_consumed = 0;
+    std::uint64_t m_line = 0;
+    std::uint64_t m_size = 0;
+    std::string m_path;
+
+    bool refill();
+
+public:
+    explicit line_reader(std::string const& path, bool map = false, std::size_t chunkSize = 1 << 20);
+    ~line_reader();
+    line_reader(line_reader const&) = delete;
+    line_reader& operator=(line_reader const&) = delete;
+
+    // False once the input is exhausted
+    bool next(std::string_view& line);
+
+    std::string const& path() const { return m_path; }
+    // Number of the line last returned, counting from 1
+    std::uint64_t line_number() const { return m_line; }
+    std::uint64_t bytes_consumed() const { return m_consumed; }
+    // File size in bytes, 0 when unknown (pipes)
+    std::uint64_t size() const { return m_size; }
+};
+
+// Buffered writer for delimited text; "-" writes to standard output
+class line_writer {
+private:
+    int m_fd = -1;
+    bool m_ownsFd = false;
+    std::vector<char> m_buffer;
+    std::size_t m_used = 0;
+    std::uint64_t m_written = 0;
+    std::string m_path;
+
+    void put(std::string_view text);
+    template<typename T>
+    void put_number(T const& value);
+
+public:
+    explicit line_writer(std::string const& path, std::size_t bufferSize = 1 << 20);
+    // Flushes; errors at this point are lost, call flush() to see them
+    ~line_writer();
+    line_writer(line_writer const&) = delete;
+    line_writer& operator=(line_writer const&) = delete;
+
+    // Writes the fields separated by delim and ends the line
+    template<typename... T>
+    void write_fields(char delim, T const&... fields);
+    void flush();
+    std::uint64_t bytes_written() const { return m_written + m_used; }
+};
+
+namespace interval_map_detail {
+
+template<typename T>
+bool parse_field(std::string_view& rest, char delim, bool last, T& field) {
+    while (!rest.empty() && rest.front() == ' ' && delim != ' ') {
+        rest.remove_prefix(1);
+    }
+    auto [ptr, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), field);
+    if (ec != std::errc()) return false;
+    rest.remove_prefix(static_cast<std::size_t>(ptr - rest.data()));
+    while (!rest.empty() && rest.front() == ' ' && delim != ' ') {
+        rest.remove_prefix(1);
+    }
+    if (last) return rest.empty();
+    if (rest.empty() || rest.front() != delim) return false;
+    rest.remove_prefix(1);
+    return true;
+}
+
+} // namespace interval_map_detail
+
+// Parses exactly sizeof...(T) numeric fields separated by delim, with
+// std::from_chars; spaces around a field are skipped. False on anything
+// else, leaving the fields partly written.
+template<typename... T>
+bool parse_fields(std::string_view line, char delim, T&... fields) {
+    static_assert((std::is_arithmetic_v<T> && ...), "fields are parsed with std::from_chars");
+    std::size_t index = 0;
+    return (interval_map_detail::parse_field(line, delim, ++index == sizeof...(T), fields) && ...);
+}
+
+template<typename T>
+void line_writer::put_number(T const& value) {
+    if (m_buffer.size() - m_used < 64) flush();
+    auto [ptr, ec] = std::to_chars(m_buffer.data() + m_used, m_buffer.data() + m_buffer.size(), value);
+    (void)ec;
+    m_used = static_cast<std::size_t>(ptr - m_buffer.data());
+}
+
+template<typename... T>
+void line_writer::write_fields(char delim, T const&... fields) {
+    bool first = true;
+    ((first ? void(first = false) : put(std::string_view(&delim, 1)), put_number(fields)), ...);
+    put("\n");
+}
+
+#endif // INTERVAL_MAP_IO_H
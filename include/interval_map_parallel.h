@@ -0,0 +1,26 @@
+#ifndef INTERVAL_MAP_PARALLEL_H
+#define INTERVAL_MAP_PARALLEL_H
+
+#include "interval_map.h"
+#include "thread_pool.h"
+#include <cstddef>
+
+// Fills out[i] with map[keys[i]] for i < n. The keys are cut into chunks
+// whose keys and results fit in a core's cache, and each chunk goes through
+// map.lookup_batch on the pool. Inputs of a couple of chunks or less run on
+// the calling thread. Map is any map with lookup_batch: interval_map or
+// frozen_interval_map.
+template<typename Map, typename K, typename V>
+void parallel_lookup(Map const& map, K const* keys, std::size_t n, V* out, thread_pool& pool);
+
+// Same result as interval_map<K, V, Storage>::from_sorted over the
+// random-access range [first, last). Chunks of the input are checked for
+// order and stripped of repeated values on the pool. The surviving
+// boundaries then go into the storage in one sequential pass. Throws
+// std::invalid_argument on out-of-order keys.
+template<typename K, typename V, typename Storage = default_storage_t<K, V>, typename RandomIt>
+interval_map<K, V, Storage> parallel_from_sorted(V const& valBegin, RandomIt first, RandomIt last, thread_pool& pool);
+
+#include "interval_map_parallel_impl.h"
+
+#endif // INTERVAL_MAP_PARALLEL_H
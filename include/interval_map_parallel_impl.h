@@ -0,0 +1,73 @@
+#ifndef INTERVAL_MAP_PARALLEL_IMPL_H
+#define INTERVAL_MAP_PARALLEL_IMPL_H
+
+#include "interval_map_parallel.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace interval_map_detail {
+
+// Items per chunk so that one chunk's input and output fill about a core's share of L2
+inline std::size_t parallel_grain(std::size_t bytesPerItem) {
+    constexpr std::size_t chunk_bytes = 256 * 1024;
+    return std::max<std::size_t>(chunk_bytes / std::max<std::size_t>(bytesPerItem, 1), 1024);
+}
+
+} // namespace interval_map_detail
+
+template<typename Map, typename K, typename V>
+void parallel_lookup(Map const& map, K const* keys, std::size_t n, V* out, thread_pool& pool) {
+    std::size_t grain = interval_map_detail::parallel_grain(sizeof(K) + sizeof(V));
+    if (pool.size() == 1 || n <= 2 * grain) {
+        map.lookup_batch(keys, n, out);
+        return;
+    }
+    pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end) {
+        map.lookup_batch(keys + begin, end - begin, out + begin);
+    });
+}
+
+template<typename K, typename V, typename Storage, typename RandomIt>
+interval_map<K, V, Storage> parallel_from_sorted(V const& valBegin, RandomIt first, RandomIt last, thread_pool& pool) {
+    std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+    std::size_t grain = interval_map_detail::parallel_grain(sizeof(K) + sizeof(V));
+    if (pool.size() == 1 || n <= 2 * grain) {
+        return interval_map<K, V, Storage>::from_sorted(valBegin, first, last);
+    }
+
+    // A boundary survives when its value differs from its predecessor's, so
+    // each chunk decides alone, looking one element back across its start
+    std::vector<std::vector<std::pair<K, V>>> parts((n + grain - 1) / grain);
+    pool.parallel_for(n, grain, [&](std::size_t begin, std::size_t end) {
+        auto& part = parts[begin / grain];
+        for (std::size_t i = begin; i < end; ++i) {
+            const auto& [key, val] = first[i];
+            if (i == 0) {
+                if (valBegin == val) continue;
+            } else {
+                const auto& [prevKey, prevVal] = first[i - 1];
+                if (!(prevKey < key)) {
+                    throw std::invalid_argument("parallel_from_sorted: keys must be strictly increasing");
+                }
+                if (prevVal == val) continue;
+            }
+            part.emplace_back(key, val);
+        }
+    });
+
+    std::vector<std::pair<K, V>> boundaries;
+    std::size_t count = 0;
+    for (auto const& part : parts) {
+        count += part.size();
+    }
+    boundaries.reserve(count);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(boundaries));
+    }
+    return interval_map<K, V, Storage>::from_sorted(valBegin, boundaries.begin(), boundaries.end());
+}
+
+#endif // INTERVAL_MAP_PARALLEL_IMPL_H
@@ -0,0 +1,65 @@
+#ifndef INTERVAL_MAP_SIMD_H
+#define INTERVAL_MAP_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define INTERVAL_MAP_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#else
+#define INTERVAL_MAP_HAVE_AVX2_KERNEL 0
+#endif
+
+namespace interval_map_detail {
+
+// Runtime ISA check; the AVX2 kernels are compiled with a target attribute so
+// the rest of the library keeps building for the baseline ISA.
+inline bool has_avx2() {
+#if INTERVAL_MAP_HAVE_AVX2_KERNEL
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#if INTERVAL_MAP_HAVE_AVX2_KERNEL
+// Descends a complete Eytzinger tree of 32-bit keys for eight queries per
+// vector, two vectors at a time so their gathers overlap. Unsigned keys are
+// compared after flipping the sign bit (bias = 0x80000000), signed ones with
+// bias = 0. Writes the leaf-level node index reached by each query.
+__attribute__((target("avx2")))
+inline void eytzinger_descend_avx2(const std::int32_t* tree, std::size_t depth, std::int32_t bias,
+                                   const std::int32_t* queries, std::size_t n, std::uint32_t* nodes) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i flip = _mm256_set1_epi32(bias);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i q0 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries + i)), flip);
+        __m256i q1 = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries + i + 8)), flip);
+        __m256i n0 = one;
+        __m256i n1 = one;
+        for (std::size_t level = 0; level < depth; ++level) {
+            __m256i k0 = _mm256_xor_si256(_mm256_i32gather_epi32(tree, n0, 4), flip);
+            __m256i k1 = _mm256_xor_si256(_mm256_i32gather_epi32(tree, n1, 4), flip);
+            // node = 2 * node + 1 - (key > query)
+            n0 = _mm256_add_epi32(_mm256_add_epi32(n0, n0), _mm256_add_epi32(one, _mm256_cmpgt_epi32(k0, q0)));
+            n1 = _mm256_add_epi32(_mm256_add_epi32(n1, n1), _mm256_add_epi32(one, _mm256_cmpgt_epi32(k1, q1)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(nodes + i), n0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(nodes + i + 8), n1);
+    }
+    for (; i < n; ++i) {
+        std::uint32_t node = 1;
+        for (std::size_t level = 0; level < depth; ++level) {
+            node = 2 * node + !((queries[i] ^ bias) < (tree[node] ^ bias));
+        }
+        nodes[i] = node;
+    }
+}
+#endif
+
+} // namespace interval_map_detail
+
+#endif // INTERVAL_MAP_SIMD_H
@@ -0,0 +1,232 @@
+#ifndef INTERVAL_MAP_SNAPSHOT_H
+#define INTERVAL_MAP_SNAPSHOT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Binary snapshot written by save_snapshot() and mapped by
+// mapped_interval_map. All sections start on 64-byte boundaries so the mapped
+// arrays can be used in place:
+//
+//   [0, 128)             snapshot_header, zero padded
+//   begin_offset         begin value
+//   keys_offset          count keys, ascending
+//   values_offset        count values, values[i] in effect from keys[i]
+//   file_size            end of file
+//
+// Integers are in the writer's byte order, recorded by endian_tag; readers
+// reject files whose tag reads differently. checksum covers every byte from
+// begin_offset to file_size.
+namespace interval_map_detail {
+
+constexpr char snapshot_magic[8] = {'I', 'M', 'A', 'P', 'S', 'N', 'A', 'P'};
+constexpr std::uint32_t snapshot_version = 1;
+constexpr std::uint32_t snapshot_endian_tag = 0x01020304;
+constexpr std::size_t snapshot_header_size = 128;
+constexpr std::size_t snapshot_alignment = 64;
+
+struct snapshot_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endian_tag;
+    std::uint32_t key_size;
+    std::uint32_t value_size;
+    std::uint64_t count;
+    std::uint64_t begin_offset;
+    std::uint64_t keys_offset;
+    std::uint64_t values_offset;
+    std::uint64_t file_size;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(snapshot_header) <= snapshot_header_size, "snapshot header outgrew its slot");
+
+constexpr std::uint64_t snapshot_align(std::uint64_t offset) {
+    return (offset + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+}
+
+// Header of a snapshot with count boundaries; checksum is filled in by the writer
+inline snapshot_header make_snapshot_header(std::uint64_t count, std::size_t keySize, std::size_t valueSize) {
+    snapshot_header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.endian_tag = snapshot_endian_tag;
+    header.key_size = static_cast<std::uint32_t>(keySize);
+    header.value_size = static_cast<std::uint32_t>(valueSize);
+    header.count = count;
+    header.begin_offset = snapshot_header_size;
+    header.keys_offset = snapshot_align(header.begin_offset + valueSize);
+    header.values_offset = snapshot_align(header.keys_offset + count * keySize);
+    header.file_size = snapshot_align(header.values_offset + count * valueSize);
+    return header;
+}
+
+// Throws std::runtime_error unless header describes a well-formed snapshot of
+// fileSize bytes holding keys and values of the given sizes
+inline void validate_snapshot_header(snapshot_header const& header, std::uint64_t fileSize,
+                                     std::size_t keySize, std::size_t valueSize) {
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("interval_map snapshot: not a snapshot file");
+    }
+    if (header.endian_tag != snapshot_endian_tag) {
+        throw std::runtime_error("interval_map snapshot: written with a different byte order");
+    }
+    if (header.version != snapshot_version) {
+        throw std::runtime_error("interval_map snapshot: unsupported version " + std::to_string(header.version));
+    }
+    if (header.key_size != keySize || header.value_size != valueSize) {
+        throw std::runtime_error("interval_map snapshot: key or value type does not match");
+    }
+    if (header.count > (fileSize - snapshot_header_size) / (keySize + valueSize)) {
+        throw std::runtime_error("interval_map snapshot: truncated file");
+    }
+    snapshot_header expected = make_snapshot_header(header.count, keySize, valueSize);
+    if (header.begin_offset != expected.begin_offset || header.keys_offset != expected.keys_offset ||
+        header.values_offset != expected.values_offset || header.file_size != expected.file_size) {
+        throw std::runtime_error("interval_map snapshot: inconsistent section layout");
+    }
+    if (header.file_size != fileSize) {
+        throw std::runtime_error("interval_map snapshot: truncated file");
+    }
+}
+
+// Word-wise multiplicative hash; every step is a bijection of the running
+// state, so any single corrupted word changes the result. n must be a
+// multiple of 8.
+inline std::uint64_t snapshot_checksum(std::uint64_t hash, const unsigned char* data, std::size_t n) {
+    for (std::size_t i = 0; i < n; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+constexpr std::uint64_t snapshot_checksum_seed = 0xcbf29ce484222325ULL;
+
+// Streams a snapshot into path + ".tmp", then fsyncs and renames it over
+// path and fsyncs the directory, so readers only ever see complete files and
+// the rename survives a crash. Abandoned writes remove the temporary file.
+class snapshot_writer {
+private:
+    static constexpr std::size_t buffer_size = 1 << 16;
+
+    std::string m_path;
+    std::string m_tmpPath;
+    int m_fd = -1;
+    std::vector<unsigned char> m_buffer;
+    std::uint64_t m_flushed = snapshot_header_size;
+    std::uint64_t m_checksum = snapshot_checksum_seed;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::system_error(errno, std::generic_category(),
+                                std::string("interval_map::save: ") + what + " " + m_tmpPath);
+    }
+
+    void pwrite_all(const unsigned char* data, std::size_t n, std::uint64_t offset) {
+        while (n > 0) {
+            ssize_t written = ::pwrite(m_fd, data, n, static_cast<off_t>(offset));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                fail("cannot write");
+            }
+            data += written;
+            n -= static_cast<std::size_t>(written);
+            offset += static_cast<std::uint64_t>(written);
+        }
+    }
+
+    // Makes the rename durable; the file itself is already synced
+    void sync_parent_directory() const {
+        std::string::size_type slash = m_path.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : m_path.substr(0, slash);
+        int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        int synced = fd < 0 ? -1 : ::fsync(fd);
+        int error = errno;
+        if (fd >= 0) ::close(fd);
+        if (synced != 0) {
+            throw std::system_error(error, std::generic_category(),
+                                    "interval_map::save: cannot sync directory " + directory);
+        }
+    }
+
+    void flush() {
+        m_checksum = snapshot_checksum(m_checksum, m_buffer.data(), m_buffer.size());
+        pwrite_all(m_buffer.data(), m_buffer.size(), m_flushed);
+        m_flushed += m_buffer.size();
+        m_buffer.clear();
+    }
+
+public:
+    explicit snapshot_writer(std::string path) : m_path(std::move(path)), m_tmpPath(m_path + ".tmp") {
+        m_fd = ::open(m_tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd < 0) fail("cannot create");
+        m_buffer.reserve(buffer_size);
+    }
+
+    snapshot_writer(snapshot_writer const&) = delete;
+    snapshot_writer& operator=(snapshot_writer const&) = delete;
+
+    ~snapshot_writer() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            ::unlink(m_tmpPath.c_str());
+        }
+    }
+
+    void write(const void* data, std::size_t n) {
+        auto const* bytes = static_cast<const unsigned char*>(data);
+        while (n > 0) {
+            std::size_t chunk = std::min(n, buffer_size - m_buffer.size());
+            m_buffer.insert(m_buffer.end(), bytes, bytes + chunk);
+            bytes += chunk;
+            n -= chunk;
+            if (m_buffer.size() == buffer_size) flush();
+        }
+    }
+
+    // Zero-fills up to the next section boundary
+    void pad() {
+        std::uint64_t offset = m_flushed + m_buffer.size();
+        static const unsigned char zeros[snapshot_alignment] = {};
+        write(zeros, static_cast<std::size_t>(snapshot_align(offset) - offset));
+    }
+
+    // Writes header once the payload is complete and publishes the file
+    void commit(snapshot_header header) {
+        pad();
+        flush();
+        if (m_flushed != header.file_size) {
+            throw std::logic_error("interval_map::save: payload does not match the snapshot layout");
+        }
+        header.checksum = m_checksum;
+        unsigned char slot[snapshot_header_size] = {};
+        std::memcpy(slot, &header, sizeof(header));
+        pwrite_all(slot, sizeof(slot), 0);
+        if (::fsync(m_fd) != 0) fail("cannot sync");
+        int closed = ::close(m_fd);
+        m_fd = -1;
+        if (closed != 0 || ::rename(m_tmpPath.c_str(), m_path.c_str()) != 0) {
+            int error = errno;
+            ::unlink(m_tmpPath.c_str());
+            errno = error;
+            fail(closed != 0 ? "cannot close" : "cannot rename");
+        }
+        sync_parent_directory();
+    }
+};
+
+} // namespace interval_map_detail
+
+#endif // INTERVAL_MAP_SNAPSHOT_H
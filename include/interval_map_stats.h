@@ -0,0 +1,215 @@
+#ifndef INTERVAL_MAP_STATS_H
+#define INTERVAL_MAP_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef INTERVAL_MAP_STATS
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <utility>
+#endif
+
+// Sampled latencies in power-of-two buckets: buckets[i] counts operations
+// that took [2^i, 2^(i+1)) nanoseconds (bucket 0 also takes 0 ns)
+struct latency_histogram {
+    static constexpr std::size_t bucket_count = 40;
+    std::array<std::uint64_t, bucket_count> buckets{};
+
+    std::uint64_t samples() const {
+        std::uint64_t total = 0;
+        for (std::uint64_t count : buckets) {
+            total += count;
+        }
+        return total;
+    }
+
+    // Upper edge of the bucket holding the p-quantile sample; 0 with no samples
+    std::uint64_t percentile_ns(double p) const {
+        std::uint64_t total = samples();
+        if (total == 0) return 0;
+        auto rank = static_cast<std::uint64_t>(p * static_cast<double>(total - 1));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets[i];
+            if (seen > rank) return std::uint64_t(2) << i;
+        }
+        return std::uint64_t(2) << (bucket_count - 1);
+    }
+};
+
+// Counters reported by interval_map::stats(). Only collected when the
+// library is built with INTERVAL_MAP_STATS defined (CMake option of the same
+// name); otherwise stats() is all zeros and the hooks compile to nothing.
+// Define it the same way in every translation unit: it changes the layout
+// of interval_map.
+struct interval_map_stats {
+#ifdef INTERVAL_MAP_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    // One assign and one lookup out of every sample_period is timed
+    static constexpr std::uint64_t sample_period = 64;
+
+    std::uint64_t assigns = 0;              // including assign_batch entries
+    std::uint64_t lookups = 0;              // operator[], lookup_batch, lookup_sorted
+    std::uint64_t boundaries_inserted = 0;
+    std::uint64_t boundaries_erased = 0;
+    std::uint64_t merges = 0;               // edges that joined an equal-valued neighbour
+    std::uint64_t size_high_water = 0;
+    latency_histogram assign_latency;
+    latency_histogram lookup_latency;
+};
+
+namespace interval_map_detail {
+
+#ifdef INTERVAL_MAP_STATS
+
+// Relaxed atomics throughout: counters are read while the map is in use and
+// lookups run concurrently, but nothing is ordered by them. Write-side
+// counters have a single writer and skip the read-modify-write.
+class stats_recorder {
+private:
+    using counter = std::atomic<std::uint64_t>;
+    using histogram = std::array<counter, latency_histogram::bucket_count>;
+
+    counter m_assigns{0};
+    counter m_lookups{0};
+    counter m_inserted{0};
+    counter m_erased{0};
+    counter m_merges{0};
+    counter m_highWater{0};
+    histogram m_assignLatency{};
+    histogram m_lookupLatency{};
+
+    static void bump(counter& c, std::uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static bool sampled(std::uint64_t before, std::uint64_t n) {
+        return before / interval_map_stats::sample_period != (before + n) / interval_map_stats::sample_period;
+    }
+
+    static void copy(histogram& to, histogram const& from) {
+        for (std::size_t i = 0; i < to.size(); ++i) {
+            to[i].store(from[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    void copy_from(stats_recorder const& other) {
+        for (auto [to, from] : {std::pair{&m_assigns, &other.m_assigns}, std::pair{&m_lookups, &other.m_lookups},
+                                std::pair{&m_inserted, &other.m_inserted}, std::pair{&m_erased, &other.m_erased},
+                                std::pair{&m_merges, &other.m_merges}, std::pair{&m_highWater, &other.m_highWater}}) {
+            to->store(from->load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        copy(m_assignLatency, other.m_assignLatency);
+        copy(m_lookupLatency, other.m_lookupLatency);
+    }
+
+public:
+    // Times its scope into a histogram when the operation was sampled
+    class timer {
+    private:
+        histogram* m_histogram;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        explicit timer(histogram* target)
+            : m_histogram(target), m_start(target ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+        timer(timer const&) = delete;
+        timer& operator=(timer const&) = delete;
+        ~timer() {
+            if (!m_histogram) return;
+            auto ns = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+            std::size_t bucket = 0;
+            while (bucket + 1 < latency_histogram::bucket_count && (ns >> (bucket + 1)) != 0) {
+                ++bucket;
+            }
+            (*m_histogram)[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    stats_recorder() = default;
+    stats_recorder(stats_recorder const& other) { copy_from(other); }
+    stats_recorder& operator=(stats_recorder const& other) {
+        copy_from(other);
+        return *this;
+    }
+
+    timer time_assign() {
+        std::uint64_t before = m_assigns.load(std::memory_order_relaxed);
+        bump(m_assigns, 1);
+        return timer(sampled(before, 1) ? &m_assignLatency : nullptr);
+    }
+    timer time_lookup() {
+        std::uint64_t before = m_lookups.fetch_add(1, std::memory_order_relaxed);
+        return timer(sampled(before, 1) ? &m_lookupLatency : nullptr);
+    }
+    template<typename Range>
+    void count_assigns(Range const& batch) {
+        bump(m_assigns, static_cast<std::uint64_t>(std::distance(std::begin(batch), std::end(batch))));
+    }
+    void inserted(std::uint64_t n) { bump(m_inserted, n); }
+    void erased(std::uint64_t n) { bump(m_erased, n); }
+    template<typename It>
+    void erased(It first, It last) { bump(m_erased, static_cast<std::uint64_t>(std::distance(first, last))); }
+    void merged() { bump(m_merges, 1); }
+    void observe_size(std::size_t size) {
+        if (size > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(size, std::memory_order_relaxed);
+        }
+    }
+
+    interval_map_stats snapshot() const {
+        interval_map_stats stats;
+        stats.assigns = m_assigns.load(std::memory_order_relaxed);
+        stats.lookups = m_lookups.load(std::memory_order_relaxed);
+        stats.boundaries_inserted = m_inserted.load(std::memory_order_relaxed);
+        stats.boundaries_erased = m_erased.load(std::memory_order_relaxed);
+        stats.merges = m_merges.load(std::memory_order_relaxed);
+        stats.size_high_water = m_highWater.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < latency_histogram::bucket_count; ++i) {
+            stats.assign_latency.buckets[i] = m_assignLatency[i].load(std::memory_order_relaxed);
+            stats.lookup_latency.buckets[i] = m_lookupLatency[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void reset() { copy_from(stats_recorder()); }
+};
+
+#else
+
+// Disabled build: every hook is an empty inline function
+class stats_recorder {
+public:
+    // The user-provided destructor marks a scope guard, so callers' timer
+    // locals do not draw unused-variable warnings
+    struct timer {
+        ~timer() {}
+    };
+
+    timer time_assign() const { return {}; }
+    timer time_lookup() const { return {}; }
+    template<typename Range>
+    void count_assigns(Range const&) const {}
+    void inserted(std::uint64_t) const {}
+    void erased(std::uint64_t) const {}
+    template<typename It>
+    void erased(It, It) const {}
+    void merged() const {}
+    void observe_size(std::size_t) const {}
+
+    interval_map_stats snapshot() const { return {}; }
+    void reset() const {}
+};
+
+#endif
+
+} // namespace interval_map_detail
+
+#endif // INTERVAL_MAP_STATS_H
@@ -2,6 +2,7 @@
 #define INTERVAL_MAP_TESTER_H
 
 #include "interval_map.h"
+#include "flat_storage.h"
 #include <random>
 #include <string>
 #include <vector>
@@ -25,7 +26,39 @@ private:
     static bool test_overlapping_intervals();
     static bool test_adjacent_intervals();
     static bool test_boundary_conditions();
+    static bool test_interval_iteration();
+    static bool test_canonical_form();
     
+    // Storage Backend Tests
+    static bool test_flat_storage();
+    static bool test_packed_storage();
+    static bool test_interned_storage();
+    static bool test_augmented_storage();
+    static bool test_frozen_lookup();
+    static bool test_pmr_allocation();
+    static bool test_batch_lookup();
+    static bool test_sorted_lookup();
+    static bool test_finger_hints();
+    static bool test_change_feed();
+    static bool test_batch_assign();
+    static bool test_buffered_writes();
+    static bool test_from_sorted();
+    static bool test_combine();
+
+    // Persistence Tests
+    static bool test_snapshot_files();
+    static bool test_write_ahead_log();
+    static bool test_persistent_versions();
+    static bool test_delimited_io();
+
+    // Concurrency Tests
+    static bool test_concurrent_readers();
+    static bool test_sharded_map();
+    static bool test_parallel_bulk();
+
+    // Instrumentation Tests
+    static bool test_stats();
+
     // Stress Testing
     static bool test_random_intervals();
     static bool test_large_operations();
@@ -34,7 +67,10 @@ private:
     // Helper Methods
     static int random_key(int min, int max);
     static void verify_interval(const interval_map<int, char>& imap, int start, int end, char val);
-    static size_t get_memory_usage(const interval_map<int, char>& imap);
+    template<typename Storage>
+    static void verify_canonical(const interval_map<int, char, Storage>& imap);
+    template<typename Storage>
+    static size_t get_memory_usage(const interval_map<int, char, Storage>& imap);
     static void print_test_result(const std::string& test_name, bool result);
 
 public:
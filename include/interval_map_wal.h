@@ -0,0 +1,82 @@
+#ifndef INTERVAL_MAP_WAL_H
+#define INTERVAL_MAP_WAL_H
+
+#include "interval_map.h"
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct wal_options {
+    // Records buffered per write + fdatasync; sync() forces one early
+    std::size_t group_commit = 64;
+    // Records applied per assign_batch call during replay
+    std::size_t replay_batch = 65536;
+};
+
+// interval_map made durable by an append-only operation log. The directory
+// holds snapshot-<gen>.snap files (save_snapshot format) and
+// log-<gen>.wal files of fixed-size checksummed assign records. A snapshot of
+// generation g holds every record of the logs before g, so recovery loads the
+// newest snapshot and replays the logs from its generation on, stopping at a
+// torn or corrupt tail. compact_async() starts a new log and writes the
+// snapshot on a background thread, then deletes what it supersedes.
+//
+// Assignments are durable once sync() returns or group_commit further records
+// have been written. Not thread-safe, like interval_map.
+template<typename K, typename V, typename Storage = default_storage_t<K, V>>
+class interval_map_wal {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "logged keys and values must be trivially copyable");
+
+private:
+    std::string m_directory;
+    wal_options m_options;
+    std::uint64_t m_generation = 0;     // of the open log; set by load_snapshot, so declared before m_map
+    interval_map<K, V, Storage> m_map;
+    int m_fd = -1;
+    std::vector<unsigned char> m_buffer;
+    std::size_t m_buffered = 0;
+    std::size_t m_replayed = 0;
+    std::future<void> m_compaction;
+
+    static interval_map<K, V, Storage> load_snapshot(std::string const& directory, V const& valBegin,
+                                                     std::uint64_t& generation);
+    void recover();
+    void replay(std::string const& path);
+    void open_log(std::uint64_t generation);
+    void close_log();
+    void write_buffer();
+    std::string log_path(std::uint64_t generation) const;
+
+public:
+    // Opens or creates directory and recovers its state; valBegin applies
+    // only while no snapshot exists. Throws std::system_error on I/O failure
+    // and std::runtime_error on a damaged snapshot.
+    interval_map_wal(std::string directory, V const& valBegin, wal_options options = {});
+    interval_map_wal(interval_map_wal const&) = delete;
+    interval_map_wal& operator=(interval_map_wal const&) = delete;
+    // Syncs outstanding records and waits for a running compaction
+    ~interval_map_wal();
+
+    interval_map<K, V, Storage> const& map() const;
+    V const& operator[](K const& key) const;
+    std::uint64_t generation() const;
+    // Records replayed by the constructor
+    std::size_t replayed() const;
+
+    void assign(K const& keyBegin, K const& keyEnd, V const& val);
+    void sync();
+
+    // Snapshots the current map (copied on this thread) in the background.
+    // Waits for the previous compaction first.
+    void compact_async();
+    // Waits for the running compaction and rethrows its failure, if any
+    void wait_compaction();
+};
+
+#include "interval_map_wal_impl.h"
+
+#endif // INTERVAL_MAP_WAL_H
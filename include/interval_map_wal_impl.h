@@ -0,0 +1,377 @@
+#ifndef INTERVAL_MAP_WAL_IMPL_H
+#define INTERVAL_MAP_WAL_IMPL_H
+
+#include "interval_map_wal.h"
+#include "interval_map_snapshot.h"
+#include "mapped_interval_map.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace interval_map_detail {
+
+constexpr char wal_magic[8] = {'I', 'M', 'A', 'P', 'W', 'A', 'L', '\0'};
+constexpr std::uint32_t wal_version = 1;
+
+struct wal_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t endian_tag;
+    std::uint32_t key_size;
+    std::uint32_t value_size;
+    std::uint64_t generation;
+};
+
+// FNV-1a; records are a few dozen bytes, so bytewise is cheap enough
+inline std::uint32_t wal_checksum(const unsigned char* data, std::size_t n) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < n; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Zero-padded generations keep directory listings in replay order
+inline std::string wal_file_name(const char* kind, std::uint64_t generation, const char* extension) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s-%020llu%s", kind, static_cast<unsigned long long>(generation), extension);
+    return name;
+}
+
+inline bool parse_wal_file_name(std::string const& name, std::string const& kind, std::string const& extension,
+                                std::uint64_t& generation) {
+    std::size_t first = kind.size() + 1;
+    if (name.size() <= first + extension.size() || name.compare(0, kind.size(), kind) != 0 ||
+        name[kind.size()] != '-' || name.compare(name.size() - extension.size(), extension.size(), extension) != 0) {
+        return false;
+    }
+    generation = 0;
+    for (std::size_t i = first; i < name.size() - extension.size(); ++i) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        generation = generation * 10 + static_cast<std::uint64_t>(name[i] - '0');
+    }
+    return true;
+}
+
+// Closes a descriptor on scope exit
+struct wal_descriptor {
+    int fd;
+    ~wal_descriptor() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+[[noreturn]] inline void wal_fail(const char* what, std::string const& path) {
+    throw std::system_error(errno, std::generic_category(), std::string("interval_map_wal: ") + what + " " + path);
+}
+
+inline void wal_write_all(int fd, const unsigned char* data, std::size_t n, std::string const& path) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            wal_fail("cannot write", path);
+        }
+        data += written;
+        n -= static_cast<std::size_t>(written);
+    }
+}
+
+// Makes created, renamed and removed entries of directory durable
+inline void sync_directory(std::string const& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) wal_fail("cannot open", directory);
+    int synced = ::fsync(fd);
+    int error = errno;
+    ::close(fd);
+    if (synced != 0) {
+        errno = error;
+        wal_fail("cannot sync", directory);
+    }
+}
+
+// Deletes logs and snapshots older than generation, and abandoned temporaries
+inline void remove_superseded(std::string const& directory, std::uint64_t generation) {
+    for (auto const& entry : std::filesystem::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        std::uint64_t found;
+        bool stale = name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0;
+        stale = stale || (parse_wal_file_name(name, "log", ".wal", found) && found < generation);
+        stale = stale || (parse_wal_file_name(name, "snapshot", ".snap", found) && found < generation);
+        if (stale) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+} // namespace interval_map_detail
+
+template<typename K, typename V, typename Storage>
+interval_map_wal<K, V, Storage>::interval_map_wal(std::string directory, V const& valBegin, wal_options options)
+    : m_directory(std::move(directory)), m_options(options), m_map(load_snapshot(m_directory, valBegin, m_generation)) {
+    m_options.group_commit = std::max<std::size_t>(m_options.group_commit, 1);
+    m_options.replay_batch = std::max<std::size_t>(m_options.replay_batch, 1);
+    recover();
+}
+
+template<typename K, typename V, typename Storage>
+interval_map_wal<K, V, Storage>::~interval_map_wal() {
+    try {
+        sync();
+    } catch (...) {
+        // Unsynced records were never promised durable
+    }
+    if (m_compaction.valid()) {
+        m_compaction.wait();
+    }
+    close_log();
+}
+
+template<typename K, typename V, typename Storage>
+std::string interval_map_wal<K, V, Storage>::log_path(std::uint64_t generation) const {
+    return m_directory + "/" + interval_map_detail::wal_file_name("log", generation, ".wal");
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage> interval_map_wal<K, V, Storage>::load_snapshot(std::string const& directory, V const& valBegin,
+                                                                           std::uint64_t& generation) {
+    using namespace interval_map_detail;
+    std::filesystem::create_directories(directory);
+
+    bool found = false;
+    generation = 0;
+    for (auto const& entry : std::filesystem::directory_iterator(directory)) {
+        std::uint64_t candidate;
+        if (parse_wal_file_name(entry.path().filename().string(), "snapshot", ".snap", candidate)) {
+            generation = found ? std::max(generation, candidate) : candidate;
+            found = true;
+        }
+    }
+    if (!found) {
+        return interval_map<K, V, Storage>(valBegin);
+    }
+
+    std::string path = directory + "/" + wal_file_name("snapshot", generation, ".snap");
+    auto snapshot = mapped_interval_map<K, V>::open(path);
+    if (!snapshot.verify()) {
+        throw std::runtime_error("interval_map_wal: snapshot " + path + " fails its checksum");
+    }
+    std::vector<std::pair<K, V>> boundaries;
+    boundaries.reserve(snapshot.size());
+    for (std::size_t i = 0; i < snapshot.size(); ++i) {
+        boundaries.emplace_back(snapshot.keys()[i], snapshot.values()[i]);
+    }
+    return interval_map<K, V, Storage>::from_sorted(snapshot.get_begin_value(), boundaries.begin(), boundaries.end());
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::recover() {
+    using namespace interval_map_detail;
+    std::vector<std::uint64_t> logs;
+    for (auto const& entry : std::filesystem::directory_iterator(m_directory)) {
+        std::uint64_t generation;
+        if (parse_wal_file_name(entry.path().filename().string(), "log", ".wal", generation)) {
+            logs.push_back(generation);
+        }
+    }
+
+    // Logs older than the snapshot are already folded into it
+    std::sort(logs.begin(), logs.end());
+    std::uint64_t snapshotGeneration = m_generation;
+    std::uint64_t next = snapshotGeneration;
+    for (std::uint64_t generation : logs) {
+        if (generation < snapshotGeneration) continue;
+        replay(log_path(generation));
+        next = generation + 1;
+    }
+    remove_superseded(m_directory, snapshotGeneration);
+
+    // Never append behind a torn tail: every session starts a fresh log
+    open_log(next);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::replay(std::string const& path) {
+    using namespace interval_map_detail;
+    constexpr std::size_t record_size = 2 * sizeof(K) + sizeof(V) + sizeof(std::uint32_t);
+
+    wal_descriptor file{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file.fd < 0) wal_fail("cannot open", path);
+
+    std::vector<unsigned char> buffer(std::max<std::size_t>(1 << 20, 2 * record_size));
+    std::size_t filled = 0;
+    auto read_more = [&] {
+        for (;;) {
+            ssize_t got = ::read(file.fd, buffer.data() + filled, buffer.size() - filled);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) wal_fail("cannot read", path);
+            filled += static_cast<std::size_t>(got);
+            return got > 0;
+        }
+    };
+
+    while (filled < sizeof(wal_header) && read_more()) {
+    }
+    // A header cut short means the log was created but nothing reached it
+    if (filled < sizeof(wal_header)) return;
+    wal_header header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (std::memcmp(header.magic, wal_magic, sizeof(wal_magic)) != 0 || header.endian_tag != snapshot_endian_tag ||
+        header.version != wal_version || header.key_size != sizeof(K) || header.value_size != sizeof(V)) {
+        throw std::runtime_error("interval_map_wal: " + path + " is not a log of this key and value type");
+    }
+
+    std::vector<interval_assignment<K, V>> batch;
+    batch.reserve(std::min<std::size_t>(m_options.replay_batch, buffer.size() / record_size));
+    std::size_t offset = sizeof(wal_header);
+    bool intact = true;
+    while (intact) {
+        for (; offset + record_size <= filled; offset += record_size) {
+            const unsigned char* record = buffer.data() + offset;
+            std::uint32_t checksum;
+            std::memcpy(&checksum, record + record_size - sizeof(checksum), sizeof(checksum));
+            if (checksum != wal_checksum(record, record_size - sizeof(checksum))) {
+                intact = false;
+                break;
+            }
+            interval_assignment<K, V> entry;
+            std::memcpy(&entry.keyBegin, record, sizeof(K));
+            std::memcpy(&entry.keyEnd, record + sizeof(K), sizeof(K));
+            std::memcpy(&entry.val, record + 2 * sizeof(K), sizeof(V));
+            batch.push_back(entry);
+            if (batch.size() == m_options.replay_batch) {
+                m_map.assign_batch(batch);
+                m_replayed += batch.size();
+                batch.clear();
+            }
+        }
+        if (!intact) break;
+        // Carry the partial record over and refill
+        std::memmove(buffer.data(), buffer.data() + offset, filled - offset);
+        filled -= offset;
+        offset = 0;
+        intact = read_more();
+    }
+    m_map.assign_batch(batch);
+    m_replayed += batch.size();
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::open_log(std::uint64_t generation) {
+    using namespace interval_map_detail;
+    std::string path = log_path(generation);
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_fd < 0) wal_fail("cannot create", path);
+    m_generation = generation;
+
+    wal_header header{};
+    std::memcpy(header.magic, wal_magic, sizeof(header.magic));
+    header.version = wal_version;
+    header.endian_tag = snapshot_endian_tag;
+    header.key_size = sizeof(K);
+    header.value_size = sizeof(V);
+    header.generation = generation;
+    wal_write_all(m_fd, reinterpret_cast<const unsigned char*>(&header), sizeof(header), path);
+    if (::fdatasync(m_fd) != 0) wal_fail("cannot sync", path);
+    sync_directory(m_directory);
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::close_log() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::write_buffer() {
+    using namespace interval_map_detail;
+    wal_write_all(m_fd, m_buffer.data(), m_buffer.size(), log_path(m_generation));
+    if (::fdatasync(m_fd) != 0) wal_fail("cannot sync", log_path(m_generation));
+    m_buffer.clear();
+    m_buffered = 0;
+}
+
+template<typename K, typename V, typename Storage>
+interval_map<K, V, Storage> const& interval_map_wal<K, V, Storage>::map() const {
+    return m_map;
+}
+
+template<typename K, typename V, typename Storage>
+V const& interval_map_wal<K, V, Storage>::operator[](K const& key) const {
+    return m_map[key];
+}
+
+template<typename K, typename V, typename Storage>
+std::uint64_t interval_map_wal<K, V, Storage>::generation() const {
+    return m_generation;
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t interval_map_wal<K, V, Storage>::replayed() const {
+    return m_replayed;
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    if (!(keyBegin < keyEnd)) return;
+    m_map.assign(keyBegin, keyEnd, val);
+
+    constexpr std::size_t record_size = 2 * sizeof(K) + sizeof(V) + sizeof(std::uint32_t);
+    std::size_t offset = m_buffer.size();
+    m_buffer.resize(offset + record_size);
+    unsigned char* record = m_buffer.data() + offset;
+    std::memcpy(record, &keyBegin, sizeof(K));
+    std::memcpy(record + sizeof(K), &keyEnd, sizeof(K));
+    std::memcpy(record + 2 * sizeof(K), &val, sizeof(V));
+    std::uint32_t checksum = interval_map_detail::wal_checksum(record, record_size - sizeof(checksum));
+    std::memcpy(record + record_size - sizeof(checksum), &checksum, sizeof(checksum));
+
+    if (++m_buffered >= m_options.group_commit) {
+        write_buffer();
+    }
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::sync() {
+    if (m_buffered > 0) {
+        write_buffer();
+    }
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::compact_async() {
+    using namespace interval_map_detail;
+    wait_compaction();
+    sync();
+
+    // Records from here on go to the new generation; the copy holds the rest
+    close_log();
+    std::uint64_t generation = m_generation + 1;
+    open_log(generation);
+    auto snapshot = std::make_shared<interval_map<K, V, Storage> const>(m_map);
+    m_compaction = std::async(std::launch::async, [snapshot, directory = m_directory, generation] {
+        // save_snapshot() syncs the directory after publishing the snapshot
+        save_snapshot(*snapshot, directory + "/" + wal_file_name("snapshot", generation, ".snap"));
+        remove_superseded(directory, generation);
+    });
+}
+
+template<typename K, typename V, typename Storage>
+void interval_map_wal<K, V, Storage>::wait_compaction() {
+    if (m_compaction.valid()) {
+        m_compaction.get();
+    }
+}
+
+#endif // INTERVAL_MAP_WAL_IMPL_H
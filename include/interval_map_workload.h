@@ -0,0 +1,67 @@
+#ifndef INTERVAL_MAP_WORKLOAD_H
+#define INTERVAL_MAP_WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <string>
+#include <vector>
+
+struct workload_options {
+    std::vector<std::string> workloads;   // empty runs every workload
+    std::size_t operations = 1000000;     // timed operations per workload
+    std::uint64_t seed = 42;
+    std::string json_path;                // "-" writes JSON to stdout
+};
+
+// Reproducible mixed assign/lookup workloads on interval_map<int, char> with
+// its default storage, packed_storage. Every operation is timed on its own;
+// results report latency percentiles per operation kind, throughput, the
+// final boundary count and the peak bytes held by the map, as a table and
+// optionally as JSON for comparing runs across releases.
+class IntervalMapWorkloads {
+private:
+    struct operation {
+        bool assign;
+        int keyBegin;
+        int keyEnd;
+        char val;
+    };
+
+    struct latency_summary {
+        std::size_t count = 0;
+        double mean = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double p999 = 0;
+        double max = 0;
+    };
+
+    struct workload_result {
+        std::string name;
+        std::size_t operations = 0;
+        double seconds = 0;
+        std::size_t boundaries = 0;
+        std::size_t peak_bytes = 0;
+        latency_summary assign;
+        latency_summary lookup;
+    };
+
+    static std::vector<operation> generate(const std::string& name, std::size_t prefill, std::size_t operations,
+                                           std::mt19937_64& gen);
+    static workload_result run_workload(const std::string& name, const workload_options& options);
+    static latency_summary summarize(std::vector<double>& latencies);
+    static void print_table(std::ostream& out, const std::vector<workload_result>& results);
+    static void write_json(std::ostream& out, const workload_options& options,
+                           const std::vector<workload_result>& results);
+
+public:
+    static const std::vector<std::string>& workload_names();
+    // Returns false if options name an unknown workload or the JSON file
+    // cannot be written
+    static bool run(const workload_options& options);
+};
+
+#endif // INTERVAL_MAP_WORKLOAD_H
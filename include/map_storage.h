@@ -0,0 +1,92 @@
+#ifndef MAP_STORAGE_H
+#define MAP_STORAGE_H
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <utility>
+
+// Default interval_map backend: one red-black tree node per boundary.
+// Iterators stay valid across inserts and erases of other boundaries.
+template<typename K, typename V, typename Alloc = std::allocator<std::pair<const K, V>>>
+class map_storage {
+private:
+    using map_type = std::map<K, V, std::less<K>,
+                              typename std::allocator_traits<Alloc>::template rebind_alloc<std::pair<const K, V>>>;
+    map_type m_map;
+
+    // libstdc++'s _Rb_tree_node: colour and three links ahead of the
+    // key-value pair. libc++ and MSVC lay nodes out differently, so there
+    // memory_usage() is an estimate.
+    struct node_layout {
+        int colour;
+        void* links[3];
+        alignas(typename map_type::value_type) unsigned char value[sizeof(typename map_type::value_type)];
+    };
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using stored_type = V;
+    using allocator_type = Alloc;
+    using iterator = typename map_type::iterator;
+    using const_iterator = typename map_type::const_iterator;
+
+    map_storage() = default;
+    explicit map_storage(Alloc const& alloc) : m_map(typename map_type::allocator_type(alloc)) {}
+
+    iterator begin() { return m_map.begin(); }
+    iterator end() { return m_map.end(); }
+    const_iterator begin() const { return m_map.begin(); }
+    const_iterator end() const { return m_map.end(); }
+
+    bool empty() const { return m_map.empty(); }
+    std::size_t size() const { return m_map.size(); }
+    void clear() { m_map.clear(); }
+
+    iterator lower_bound(K const& key) { return m_map.lower_bound(key); }
+    iterator upper_bound(K const& key) { return m_map.upper_bound(key); }
+    const_iterator lower_bound(K const& key) const { return m_map.lower_bound(key); }
+    const_iterator upper_bound(K const& key) const { return m_map.upper_bound(key); }
+
+    // upper_bound(key) for a key no smaller than every boundary before it.
+    // Sorted query streams mostly move a boundary or two, so walk a few
+    // nodes before falling back to a fresh descent from the root.
+    const_iterator upper_bound_from(const_iterator it, K const& key) const {
+        for (int step = 0; step < 8; ++step) {
+            if (it == m_map.end() || key < it->first) return it;
+            ++it;
+        }
+        return m_map.upper_bound(key);
+    }
+
+    // Mutable iterator to the same boundary, in O(1)
+    iterator to_mutable(const_iterator it) { return m_map.erase(it, it); }
+
+    // Values are stored as they are, so their stored form is the value itself
+    void bind_begin_value(V const&) {}
+    V const& stored_begin(V const& valBegin) const { return valBegin; }
+    V const& intern(V const& val) { return val; }
+
+    K const& key(const_iterator it) const { return it->first; }
+    V const& value(const_iterator it) const { return it->second; }
+    V const& stored(const_iterator it) const { return it->second; }
+    void set_stored(iterator it, V const& val) { it->second = val; }
+
+    // Inserts a boundary that sorts immediately before hint
+    iterator insert(iterator hint, K const& key, V const& val) {
+        return m_map.emplace_hint(hint, key, val);
+    }
+
+    iterator erase(iterator first, iterator last) { return m_map.erase(first, last); }
+
+    // Adds a boundary greater than every existing one in amortized O(1)
+    void append(K key, V val) { m_map.emplace_hint(m_map.end(), std::move(key), std::move(val)); }
+
+    // Bytes held in tree nodes; exact for libstdc++, an estimate elsewhere
+    std::size_t memory_usage() const { return m_map.size() * sizeof(node_layout); }
+};
+
+#endif // MAP_STORAGE_H
@@ -0,0 +1,66 @@
+#ifndef MAPPED_INTERVAL_MAP_H
+#define MAPPED_INTERVAL_MAP_H
+
+#include "interval_map.h"
+#include "interval_map_snapshot.h"
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+// Read-only interval_map served straight from a snapshot written by
+// save_snapshot(). open() maps the file and checks its header; lookups
+// binary-search the mapped key array, so nothing is deserialized and
+// processes mapping the same file share its page cache.
+template<typename K, typename V>
+class mapped_interval_map {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "snapshots hold trivially copyable keys and values");
+    static_assert(alignof(K) <= interval_map_detail::snapshot_alignment &&
+                  alignof(V) <= interval_map_detail::snapshot_alignment,
+                  "snapshot sections are 64-byte aligned");
+
+private:
+    void* m_address = nullptr;
+    std::size_t m_length = 0;
+    V const* m_valBegin = nullptr;
+    K const* m_keys = nullptr;
+    V const* m_values = nullptr;
+    std::size_t m_size = 0;
+
+    mapped_interval_map(void* address, std::size_t length);
+    void unmap();
+
+public:
+    // Throws std::system_error if the file cannot be mapped and
+    // std::runtime_error if it is not a snapshot of K and V
+    static mapped_interval_map open(std::string const& path);
+
+    mapped_interval_map(mapped_interval_map&& other) noexcept;
+    mapped_interval_map& operator=(mapped_interval_map&& other) noexcept;
+    mapped_interval_map(mapped_interval_map const&) = delete;
+    mapped_interval_map& operator=(mapped_interval_map const&) = delete;
+    ~mapped_interval_map();
+
+    std::size_t size() const;
+    V const& get_begin_value() const;
+    // The mapped boundary arrays, size() elements each; values()[i] is in
+    // effect from keys()[i]
+    K const* keys() const;
+    V const* values() const;
+
+    V const& operator[](K const& key) const;
+
+    // Recomputes the checksum over the whole file; touches every page
+    bool verify() const;
+};
+
+// Writes imap in the binary snapshot format that mapped_interval_map opens,
+// replacing path atomically. K and V must be trivially copyable. Throws
+// std::system_error on I/O failure. Lives here rather than in interval_map.h
+// so the core map needs no POSIX headers.
+template<typename K, typename V, typename Storage>
+void save_snapshot(interval_map<K, V, Storage> const& imap, std::string const& path);
+
+#include "mapped_interval_map_impl.h"
+
+#endif // MAPPED_INTERVAL_MAP_H
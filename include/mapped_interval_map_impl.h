@@ -0,0 +1,158 @@
+#ifndef MAPPED_INTERVAL_MAP_IMPL_H
+#define MAPPED_INTERVAL_MAP_IMPL_H
+
+#include "mapped_interval_map.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+template<typename K, typename V>
+mapped_interval_map<K, V>::mapped_interval_map(void* address, std::size_t length)
+    : m_address(address), m_length(length) {
+    using namespace interval_map_detail;
+    snapshot_header header;
+    std::memcpy(&header, address, sizeof(header));
+    try {
+        validate_snapshot_header(header, length, sizeof(K), sizeof(V));
+    } catch (...) {
+        unmap();
+        throw;
+    }
+    auto const* base = static_cast<const unsigned char*>(address);
+    m_valBegin = reinterpret_cast<V const*>(base + header.begin_offset);
+    m_keys = reinterpret_cast<K const*>(base + header.keys_offset);
+    m_values = reinterpret_cast<V const*>(base + header.values_offset);
+    m_size = static_cast<std::size_t>(header.count);
+}
+
+template<typename K, typename V>
+mapped_interval_map<K, V> mapped_interval_map<K, V>::open(std::string const& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "mapped_interval_map: cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "mapped_interval_map: cannot stat " + path);
+    }
+    auto length = static_cast<std::size_t>(info.st_size);
+    if (length < interval_map_detail::snapshot_header_size) {
+        ::close(fd);
+        throw std::runtime_error("mapped_interval_map: " + path + " is too short to be a snapshot");
+    }
+    // The mapping keeps the file alive after the descriptor is closed
+    void* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), "mapped_interval_map: cannot map " + path);
+    }
+    return mapped_interval_map(address, length);
+}
+
+template<typename K, typename V>
+mapped_interval_map<K, V>::mapped_interval_map(mapped_interval_map&& other) noexcept
+    : m_address(std::exchange(other.m_address, nullptr)),
+      m_length(std::exchange(other.m_length, 0)),
+      m_valBegin(other.m_valBegin),
+      m_keys(other.m_keys),
+      m_values(other.m_values),
+      m_size(std::exchange(other.m_size, 0)) {}
+
+template<typename K, typename V>
+mapped_interval_map<K, V>& mapped_interval_map<K, V>::operator=(mapped_interval_map&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        m_address = std::exchange(other.m_address, nullptr);
+        m_length = std::exchange(other.m_length, 0);
+        m_valBegin = other.m_valBegin;
+        m_keys = other.m_keys;
+        m_values = other.m_values;
+        m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+}
+
+template<typename K, typename V>
+mapped_interval_map<K, V>::~mapped_interval_map() {
+    unmap();
+}
+
+template<typename K, typename V>
+void mapped_interval_map<K, V>::unmap() {
+    if (m_address) {
+        ::munmap(m_address, m_length);
+        m_address = nullptr;
+    }
+}
+
+template<typename K, typename V>
+std::size_t mapped_interval_map<K, V>::size() const {
+    return m_size;
+}
+
+template<typename K, typename V>
+V const& mapped_interval_map<K, V>::get_begin_value() const {
+    return *m_valBegin;
+}
+
+template<typename K, typename V>
+K const* mapped_interval_map<K, V>::keys() const {
+    return m_keys;
+}
+
+template<typename K, typename V>
+V const* mapped_interval_map<K, V>::values() const {
+    return m_values;
+}
+
+template<typename K, typename V>
+V const& mapped_interval_map<K, V>::operator[](K const& key) const {
+    K const* it = std::upper_bound(m_keys, m_keys + m_size, key);
+    if (it == m_keys) {
+        return *m_valBegin;
+    }
+    return m_values[it - m_keys - 1];
+}
+
+template<typename K, typename V>
+bool mapped_interval_map<K, V>::verify() const {
+    using namespace interval_map_detail;
+    snapshot_header header;
+    std::memcpy(&header, m_address, sizeof(header));
+    auto const* base = static_cast<const unsigned char*>(m_address);
+    std::uint64_t checksum = snapshot_checksum(snapshot_checksum_seed, base + header.begin_offset,
+                                               m_length - header.begin_offset);
+    return checksum == header.checksum;
+}
+
+template<typename K, typename V, typename Storage>
+void save_snapshot(interval_map<K, V, Storage> const& imap, std::string const& path) {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                  "snapshots hold trivially copyable keys and values");
+    using namespace interval_map_detail;
+    Storage const& storage = imap.get_storage();
+    snapshot_writer writer(path);
+    writer.write(&imap.get_begin_value(), sizeof(V));
+    writer.pad();
+    for (auto it = storage.begin(); it != storage.end(); ++it) {
+        writer.write(&storage.key(it), sizeof(K));
+    }
+    writer.pad();
+    for (auto it = storage.begin(); it != storage.end(); ++it) {
+        writer.write(&storage.value(it), sizeof(V));
+    }
+    writer.commit(make_snapshot_header(storage.size(), sizeof(K), sizeof(V)));
+}
+
+#endif // MAPPED_INTERVAL_MAP_IMPL_H
@@ -0,0 +1,95 @@
+#ifndef NODE_POOL_RESOURCE_H
+#define NODE_POOL_RESOURCE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Memory resource that recycles blocks of a single size through an intrusive
+// free list, tuned for tree nodes: the block size is taken from the first
+// allocation, and later requests of that size never reach the upstream
+// resource once a freed block is available. Blocks are carved from chunks
+// that double in size; other sizes are forwarded upstream. Not thread-safe.
+class node_pool_resource : public std::pmr::memory_resource {
+private:
+    struct free_block {
+        free_block* next;
+    };
+
+    std::pmr::memory_resource* m_upstream;
+    std::size_t m_blockSize = 0;
+    std::size_t m_blockAlign = 0;
+    std::size_t m_chunkBlocks = 64;
+    free_block* m_free = nullptr;
+    std::vector<std::pair<void*, std::size_t>> m_chunks;
+
+    void refill() {
+        void* chunk = m_upstream->allocate(m_blockSize * m_chunkBlocks, m_blockAlign);
+        m_chunks.emplace_back(chunk, m_blockSize * m_chunkBlocks);
+        char* bytes = static_cast<char*>(chunk);
+        for (std::size_t i = m_chunkBlocks; i > 0; --i) {
+            auto* block = reinterpret_cast<free_block*>(bytes + (i - 1) * m_blockSize);
+            block->next = m_free;
+            m_free = block;
+        }
+        m_chunkBlocks = std::min<std::size_t>(m_chunkBlocks * 2, 65536);
+    }
+
+    bool pooled(std::size_t bytes, std::size_t alignment) const {
+        return bytes <= m_blockSize && alignment <= m_blockAlign;
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (m_blockSize == 0) {
+            m_blockAlign = std::max(alignment, alignof(free_block));
+            m_blockSize = (std::max(bytes, sizeof(free_block)) + m_blockAlign - 1) / m_blockAlign * m_blockAlign;
+        }
+        if (!pooled(bytes, alignment)) {
+            return m_upstream->allocate(bytes, alignment);
+        }
+        if (!m_free) {
+            refill();
+        }
+        free_block* block = m_free;
+        m_free = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        if (!pooled(bytes, alignment)) {
+            m_upstream->deallocate(p, bytes, alignment);
+            return;
+        }
+        auto* block = static_cast<free_block*>(p);
+        block->next = m_free;
+        m_free = block;
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit node_pool_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream) {}
+    node_pool_resource(node_pool_resource const&) = delete;
+    node_pool_resource& operator=(node_pool_resource const&) = delete;
+    ~node_pool_resource() override { release(); }
+
+    // Returns every chunk upstream; all blocks handed out become invalid
+    void release() {
+        for (auto const& [chunk, bytes] : m_chunks) {
+            m_upstream->deallocate(chunk, bytes, m_blockAlign);
+        }
+        m_chunks.clear();
+        m_free = nullptr;
+        m_chunkBlocks = 64;
+    }
+
+    std::size_t block_size() const { return m_blockSize; }
+};
+
+#endif // NODE_POOL_RESOURCE_H
@@ -0,0 +1,578 @@
+#ifndef PACKED_STORAGE_H
+#define PACKED_STORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Keys and values small and trivial enough to be packed into blocks
+template<typename K, typename V>
+inline constexpr bool is_packable_v =
+    std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V> &&
+    std::is_trivially_default_constructible_v<K> && std::is_trivially_default_constructible_v<V> &&
+    sizeof(K) <= 16 && sizeof(V) <= 16;
+
+// Compact interval_map backend for small trivially copyable keys and values:
+// a B+ tree whose leaves hold two cache lines of sorted keys with the values
+// in a separate array beside them. Per boundary it costs the payload plus a
+// couple of bytes of tree, against a full node for map_storage. Leaves are
+// rebalanced with their siblings before splitting and merged when they run
+// low, and appends fill leaves completely. Inserts and erases invalidate
+// all iterators; values are copied before any move, so they may refer into
+// the map.
+template<typename K, typename V, typename Alloc = std::allocator<std::pair<const K, V>>>
+class packed_storage {
+    static_assert(is_packable_v<K, V>, "packed_storage needs small trivially copyable keys and values");
+
+public:
+    static constexpr std::size_t leaf_capacity = std::max<std::size_t>(128 / sizeof(K), 8);
+    static constexpr std::size_t inner_capacity = leaf_capacity;
+
+private:
+    struct leaf {
+        K keys[leaf_capacity];
+        V values[leaf_capacity];
+        leaf* prev;
+        leaf* next;
+        std::uint8_t count;
+    };
+
+    // children[i] holds keys in [keys[i-1], keys[i]); count keys, count + 1 children
+    struct inner {
+        K keys[inner_capacity];
+        void* children[inner_capacity + 1];
+        std::uint8_t count;
+    };
+
+    struct path_entry {
+        inner* node;
+        std::size_t index;
+    };
+    // Height stays far below this: each level multiplies the leaf count by at least 2
+    static constexpr std::size_t max_height = 64;
+
+    template<typename T>
+    using rebind = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    using leaf_allocator = rebind<leaf>;
+    using inner_allocator = rebind<inner>;
+
+    leaf_allocator m_leafAlloc;
+    inner_allocator m_innerAlloc;
+    void* m_root = nullptr;
+    std::size_t m_height = 0;   // inner levels above the leaves
+    leaf* m_first = nullptr;
+    leaf* m_last = nullptr;
+    std::size_t m_size = 0;
+    std::size_t m_leaves = 0;
+    std::size_t m_inners = 0;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using stored_type = V;
+    using allocator_type = Alloc;
+
+    class iterator {
+    private:
+        friend class packed_storage;
+        packed_storage const* m_storage = nullptr;
+        leaf* m_leaf = nullptr;     // nullptr at end
+        std::size_t m_slot = 0;
+
+        iterator(packed_storage const* storage, leaf* at, std::size_t slot)
+            : m_storage(storage), m_leaf(at), m_slot(slot) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::pair<K const&, V const&>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator() = default;
+
+        reference operator*() const { return {m_leaf->keys[m_slot], m_leaf->values[m_slot]}; }
+
+        iterator& operator++() {
+            if (++m_slot == m_leaf->count) {
+                m_leaf = m_leaf->next;
+                m_slot = 0;
+            }
+            return *this;
+        }
+        iterator& operator--() {
+            if (!m_leaf) {
+                m_leaf = m_storage->m_last;
+                m_slot = m_leaf->count - 1;
+            } else if (m_slot == 0) {
+                m_leaf = m_leaf->prev;
+                m_slot = m_leaf->count - 1;
+            } else {
+                --m_slot;
+            }
+            return *this;
+        }
+        iterator operator++(int) { iterator tmp = *this; ++*this; return tmp; }
+        iterator operator--(int) { iterator tmp = *this; --*this; return tmp; }
+
+        bool operator==(iterator const& other) const { return m_leaf == other.m_leaf && m_slot == other.m_slot; }
+        bool operator!=(iterator const& other) const { return !(*this == other); }
+    };
+    using const_iterator = iterator;
+
+    packed_storage() = default;
+    explicit packed_storage(Alloc const& alloc) : m_leafAlloc(alloc), m_innerAlloc(alloc) {}
+
+    // Copies are rebuilt by appending, which leaves them fully packed
+    packed_storage(packed_storage const& other)
+        : m_leafAlloc(std::allocator_traits<leaf_allocator>::select_on_container_copy_construction(other.m_leafAlloc)),
+          m_innerAlloc(std::allocator_traits<inner_allocator>::select_on_container_copy_construction(other.m_innerAlloc)) {
+        for (auto it = other.begin(); it != other.end(); ++it) {
+            append(it.m_leaf->keys[it.m_slot], it.m_leaf->values[it.m_slot]);
+        }
+    }
+    packed_storage(packed_storage&& other) noexcept
+        : m_leafAlloc(std::move(other.m_leafAlloc)), m_innerAlloc(std::move(other.m_innerAlloc)) {
+        steal(other);
+    }
+    packed_storage& operator=(packed_storage const& other) {
+        if (this != &other) {
+            clear();
+            for (auto it = other.begin(); it != other.end(); ++it) {
+                append(it.m_leaf->keys[it.m_slot], it.m_leaf->values[it.m_slot]);
+            }
+        }
+        return *this;
+    }
+    packed_storage& operator=(packed_storage&& other) noexcept {
+        if (this != &other) {
+            clear();
+            m_leafAlloc = std::move(other.m_leafAlloc);
+            m_innerAlloc = std::move(other.m_innerAlloc);
+            steal(other);
+        }
+        return *this;
+    }
+    ~packed_storage() { clear(); }
+
+    iterator begin() const { return iterator(this, m_first, 0); }
+    iterator end() const { return iterator(this, nullptr, 0); }
+
+    bool empty() const { return m_size == 0; }
+    std::size_t size() const { return m_size; }
+
+    void clear() {
+        if (m_height > 0) {
+            free_inner(static_cast<inner*>(m_root), m_height);
+        }
+        for (leaf* at = m_first; at;) {
+            leaf* next = at->next;
+            free_leaf(at);
+            at = next;
+        }
+        m_root = nullptr;
+        m_height = 0;
+        m_first = m_last = nullptr;
+        m_size = 0;
+    }
+
+    iterator lower_bound(K const& key) const {
+        if (!m_root) return end();
+        leaf* at = descend(key, nullptr);
+        return normalized(at, std::lower_bound(at->keys, at->keys + at->count, key) - at->keys);
+    }
+    iterator upper_bound(K const& key) const {
+        if (!m_root) return end();
+        leaf* at = descend(key, nullptr);
+        return normalized(at, std::upper_bound(at->keys, at->keys + at->count, key) - at->keys);
+    }
+
+    // upper_bound(key) for a key no smaller than every boundary before it:
+    // stays within the current or next leaf when it can
+    iterator upper_bound_from(iterator it, K const& key) const {
+        for (int step = 0; step < 2 && it.m_leaf; ++step) {
+            leaf* at = it.m_leaf;
+            if (key < at->keys[at->count - 1]) {
+                return iterator(this, at, std::upper_bound(at->keys + it.m_slot, at->keys + at->count, key) - at->keys);
+            }
+            it = iterator(this, at->next, 0);
+        }
+        return it.m_leaf ? upper_bound(key) : it;
+    }
+
+    // Iterators already permit modification
+    iterator to_mutable(iterator it) { return it; }
+
+    // Values are stored as they are; intern() hands out a copy so a value
+    // read from the map stays valid while the blocks shift
+    void bind_begin_value(V const&) {}
+    V const& stored_begin(V const& valBegin) const { return valBegin; }
+    V intern(V const& val) { return val; }
+
+    K const& key(iterator it) const { return it.m_leaf->keys[it.m_slot]; }
+    V const& value(iterator it) const { return it.m_leaf->values[it.m_slot]; }
+    V stored(iterator it) const { return it.m_leaf->values[it.m_slot]; }
+    void set_stored(iterator it, V const& val) { it.m_leaf->values[it.m_slot] = val; }
+
+    // Inserts a boundary that sorts immediately before hint
+    iterator insert(iterator hint, K const& key, V const& val) {
+        K const k = key;
+        V const v = val;
+        // Inside a leaf with room, hint is the exact spot and no separator moves
+        if (hint.m_leaf && hint.m_slot > 0 && hint.m_leaf->count < leaf_capacity) {
+            place(hint.m_leaf, hint.m_slot, k, v);
+            return hint;
+        }
+        if (!m_root) {
+            leaf* at = new_leaf();
+            m_root = m_first = m_last = at;
+            place(at, 0, k, v);
+            return begin();
+        }
+        path_entry path[max_height];
+        leaf* at = descend(k, path);
+        return insert_at(path, at, std::lower_bound(at->keys, at->keys + at->count, k) - at->keys, k, v);
+    }
+
+    iterator erase(iterator first, iterator last) {
+        if (first == last) return last;
+        bool toEnd = last.m_leaf == nullptr;
+        K const resume = toEnd ? K() : key(last);
+
+        leaf* head = first.m_leaf;
+        if (head == last.m_leaf) {
+            remove_slots(head, first.m_slot, last.m_slot);
+        } else {
+            // Leaf counts shrink in place, so keys[0] still routes to a leaf
+            // until it is unlinked
+            m_size -= head->count - first.m_slot;
+            head->count = static_cast<std::uint8_t>(first.m_slot);
+            for (leaf* at = head->next; at != last.m_leaf;) {
+                leaf* next = at->next;
+                m_size -= at->count;
+                remove_leaf(at);
+                at = next;
+            }
+            if (last.m_leaf) {
+                remove_slots(last.m_leaf, 0, last.m_slot);
+                merge_if_sparse(last.m_leaf);
+            }
+            if (head->count == 0) {
+                remove_leaf(head);
+                head = nullptr;
+            }
+        }
+        if (head) {
+            merge_if_sparse(head);
+        }
+        return toEnd ? end() : lower_bound(resume);
+    }
+
+    // Adds a boundary greater than every existing one in amortized O(1)
+    void append(K key, V val) {
+        if (m_last && m_last->count < leaf_capacity) {
+            place(m_last, m_last->count, key, val);
+        } else {
+            insert(end(), key, val);
+        }
+    }
+
+    // Bytes held in leaf and inner nodes
+    std::size_t memory_usage() const { return m_leaves * sizeof(leaf) + m_inners * sizeof(inner); }
+
+private:
+    leaf* new_leaf() {
+        leaf* at = std::allocator_traits<leaf_allocator>::allocate(m_leafAlloc, 1);
+        ::new (static_cast<void*>(at)) leaf;
+        at->prev = at->next = nullptr;
+        at->count = 0;
+        ++m_leaves;
+        return at;
+    }
+    void free_leaf(leaf* at) {
+        std::allocator_traits<leaf_allocator>::deallocate(m_leafAlloc, at, 1);
+        --m_leaves;
+    }
+    inner* new_inner() {
+        inner* node = std::allocator_traits<inner_allocator>::allocate(m_innerAlloc, 1);
+        ::new (static_cast<void*>(node)) inner;
+        node->count = 0;
+        ++m_inners;
+        return node;
+    }
+    void free_inner(inner* node, std::size_t height) {
+        if (height > 1) {
+            for (std::size_t i = 0; i <= node->count; ++i) {
+                free_inner(static_cast<inner*>(node->children[i]), height - 1);
+            }
+        }
+        std::allocator_traits<inner_allocator>::deallocate(m_innerAlloc, node, 1);
+        --m_inners;
+    }
+
+    void steal(packed_storage& other) {
+        m_root = std::exchange(other.m_root, nullptr);
+        m_height = std::exchange(other.m_height, 0);
+        m_first = std::exchange(other.m_first, nullptr);
+        m_last = std::exchange(other.m_last, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_leaves = std::exchange(other.m_leaves, 0);
+        m_inners = std::exchange(other.m_inners, 0);
+    }
+
+    iterator normalized(leaf* at, std::size_t slot) const {
+        return slot == at->count ? iterator(this, at->next, 0) : iterator(this, at, slot);
+    }
+
+    // Leaf whose key range holds key, recording the child taken at each level
+    leaf* descend(K const& key, path_entry* path) const {
+        void* node = m_root;
+        for (std::size_t level = m_height; level-- > 0;) {
+            inner* in = static_cast<inner*>(node);
+            std::size_t index = std::upper_bound(in->keys, in->keys + in->count, key) - in->keys;
+            if (path) path[level] = {in, index};
+            node = in->children[index];
+        }
+        return static_cast<leaf*>(node);
+    }
+
+    void place(leaf* at, std::size_t slot, K const& key, V const& val) {
+        std::copy_backward(at->keys + slot, at->keys + at->count, at->keys + at->count + 1);
+        std::copy_backward(at->values + slot, at->values + at->count, at->values + at->count + 1);
+        at->keys[slot] = key;
+        at->values[slot] = val;
+        ++at->count;
+        ++m_size;
+    }
+
+    void remove_slots(leaf* at, std::size_t from, std::size_t to) {
+        std::copy(at->keys + to, at->keys + at->count, at->keys + from);
+        std::copy(at->values + to, at->values + at->count, at->values + from);
+        at->count = static_cast<std::uint8_t>(at->count - (to - from));
+        m_size -= to - from;
+    }
+
+    // Moves the last n entries of from to the front of to
+    static void move_tail(leaf* from, leaf* to, std::size_t n) {
+        std::copy_backward(to->keys, to->keys + to->count, to->keys + to->count + n);
+        std::copy_backward(to->values, to->values + to->count, to->values + to->count + n);
+        std::copy(from->keys + from->count - n, from->keys + from->count, to->keys);
+        std::copy(from->values + from->count - n, from->values + from->count, to->values);
+        from->count = static_cast<std::uint8_t>(from->count - n);
+        to->count = static_cast<std::uint8_t>(to->count + n);
+    }
+
+    // Moves the first n entries of from to the back of to
+    static void move_head(leaf* from, leaf* to, std::size_t n) {
+        std::copy(from->keys, from->keys + n, to->keys + to->count);
+        std::copy(from->values, from->values + n, to->values + to->count);
+        std::copy(from->keys + n, from->keys + from->count, from->keys);
+        std::copy(from->values + n, from->values + from->count, from->values);
+        from->count = static_cast<std::uint8_t>(from->count - n);
+        to->count = static_cast<std::uint8_t>(to->count + n);
+    }
+
+    iterator insert_at(path_entry* path, leaf* at, std::size_t slot, K const& key, V const& val) {
+        if (at->count < leaf_capacity) {
+            place(at, slot, key, val);
+            return iterator(this, at, slot);
+        }
+
+        // A full leaf first sheds half the difference to a sibling with room
+        if (m_height > 0) {
+            inner* parent = path[0].node;
+            std::size_t index = path[0].index;
+            if (index < parent->count) {
+                leaf* right = static_cast<leaf*>(parent->children[index + 1]);
+                std::size_t n = (leaf_capacity - right->count) / 2;
+                if (n > 0) {
+                    move_tail(at, right, n);
+                    parent->keys[index] = right->keys[0];
+                    if (slot > at->count) {
+                        place(right, slot - at->count, key, val);
+                        return iterator(this, right, slot - at->count);
+                    }
+                    place(at, slot, key, val);
+                    return iterator(this, at, slot);
+                }
+            }
+            if (index > 0) {
+                leaf* left = static_cast<leaf*>(parent->children[index - 1]);
+                std::size_t n = (leaf_capacity - left->count) / 2;
+                if (n > 0) {
+                    std::size_t leftCount = left->count;
+                    move_head(at, left, n);
+                    parent->keys[index - 1] = at->keys[0];
+                    if (slot <= n) {
+                        place(left, leftCount + slot, key, val);
+                        return iterator(this, left, leftCount + slot);
+                    }
+                    place(at, slot - n, key, val);
+                    return iterator(this, at, slot - n);
+                }
+            }
+        }
+
+        // Split; appending past the last leaf starts an empty one, so
+        // sequential builds leave every leaf full
+        bool appending = !at->next && slot == leaf_capacity;
+        leaf* right = new_leaf();
+        right->prev = at;
+        right->next = at->next;
+        (at->next ? at->next->prev : m_last) = right;
+        at->next = right;
+        iterator placed;
+        if (appending) {
+            place(right, 0, key, val);
+            placed = iterator(this, right, 0);
+        } else {
+            move_tail(at, right, leaf_capacity / 2);
+            if (slot <= at->count) {
+                place(at, slot, key, val);
+                placed = iterator(this, at, slot);
+            } else {
+                place(right, slot - at->count, key, val);
+                placed = iterator(this, right, slot - at->count);
+            }
+        }
+        insert_child(path, 0, right->keys[0], right);
+        return placed;
+    }
+
+    bool rightmost_above(path_entry const* path, std::size_t level) const {
+        for (std::size_t l = level; l < m_height; ++l) {
+            if (path[l].index != path[l].node->count) return false;
+        }
+        return true;
+    }
+
+    // Adds child to the right of the node path[level] descended through
+    void insert_child(path_entry* path, std::size_t level, K const& separator, void* child) {
+        if (level == m_height) {
+            inner* root = new_inner();
+            root->count = 1;
+            root->keys[0] = separator;
+            root->children[0] = m_root;
+            root->children[1] = child;
+            m_root = root;
+            ++m_height;
+            return;
+        }
+
+        inner* in = path[level].node;
+        std::size_t index = path[level].index;
+        if (in->count < inner_capacity) {
+            std::copy_backward(in->keys + index, in->keys + in->count, in->keys + in->count + 1);
+            std::copy_backward(in->children + index + 1, in->children + in->count + 1, in->children + in->count + 2);
+            in->keys[index] = separator;
+            in->children[index + 1] = child;
+            ++in->count;
+            return;
+        }
+
+        inner* right = new_inner();
+        K up;
+        if (rightmost_above(path, level)) {
+            // Appending along the right spine: keep this node full
+            right->children[0] = child;
+            up = separator;
+        } else {
+            K keys[inner_capacity + 1];
+            void* children[inner_capacity + 2];
+            std::copy(in->keys, in->keys + index, keys);
+            keys[index] = separator;
+            std::copy(in->keys + index, in->keys + in->count, keys + index + 1);
+            std::copy(in->children, in->children + index + 1, children);
+            children[index + 1] = child;
+            std::copy(in->children + index + 1, in->children + in->count + 1, children + index + 2);
+
+            std::size_t middle = (inner_capacity + 1) / 2;
+            in->count = static_cast<std::uint8_t>(middle);
+            std::copy(keys, keys + middle, in->keys);
+            std::copy(children, children + middle + 1, in->children);
+            right->count = static_cast<std::uint8_t>(inner_capacity - middle);
+            std::copy(keys + middle + 1, keys + inner_capacity + 1, right->keys);
+            std::copy(children + middle + 1, children + inner_capacity + 2, right->children);
+            up = keys[middle];
+        }
+        insert_child(path, level + 1, up, right);
+    }
+
+    // Unlinks a leaf and drops it from the tree; its keys[0] must still route to it
+    void remove_leaf(leaf* at) {
+        (at->prev ? at->prev->next : m_first) = at->next;
+        (at->next ? at->next->prev : m_last) = at->prev;
+        if (m_height == 0) {
+            m_root = nullptr;
+        } else {
+            path_entry path[max_height];
+            descend(at->keys[0], path);
+            remove_child(path, 0);
+        }
+        free_leaf(at);
+    }
+
+    // Removes the child path[level] descended through
+    void remove_child(path_entry* path, std::size_t level) {
+        inner* in = path[level].node;
+        std::size_t index = path[level].index;
+        if (in->count == 0) {
+            std::allocator_traits<inner_allocator>::deallocate(m_innerAlloc, in, 1);
+            --m_inners;
+            if (level + 1 == m_height) {
+                m_root = nullptr;
+                m_height = 0;
+            } else {
+                remove_child(path, level + 1);
+            }
+            return;
+        }
+
+        // The child's range joins its left neighbour's (or, for the first
+        // child, the next one takes over the lower bound)
+        std::size_t separator = index > 0 ? index - 1 : 0;
+        std::copy(in->keys + separator + 1, in->keys + in->count, in->keys + separator);
+        std::copy(in->children + index + 1, in->children + in->count + 1, in->children + index);
+        --in->count;
+
+        while (m_height > 0 && static_cast<inner*>(m_root)->count == 0) {
+            inner* root = static_cast<inner*>(m_root);
+            m_root = root->children[0];
+            std::allocator_traits<inner_allocator>::deallocate(m_innerAlloc, root, 1);
+            --m_inners;
+            --m_height;
+        }
+    }
+
+    // Folds a leaf that fell below half full into a sibling under the
+    // same parent; move_head leaves the emptied leaf's keys[0] in place
+    void merge_if_sparse(leaf* at) {
+        if (m_height == 0 || at->count >= leaf_capacity / 2) return;
+        path_entry path[max_height];
+        descend(at->keys[0], path);
+        inner* parent = path[0].node;
+        std::size_t index = path[0].index;
+        if (index < parent->count) {
+            leaf* right = static_cast<leaf*>(parent->children[index + 1]);
+            if (at->count + right->count <= leaf_capacity) {
+                move_head(right, at, right->count);
+                remove_leaf(right);
+                return;
+            }
+        }
+        if (index > 0) {
+            leaf* left = static_cast<leaf*>(parent->children[index - 1]);
+            if (at->count + left->count <= leaf_capacity) {
+                move_head(at, left, at->count);
+                remove_leaf(at);
+            }
+        }
+    }
+};
+
+#endif // PACKED_STORAGE_H
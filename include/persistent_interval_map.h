@@ -0,0 +1,99 @@
+#ifndef PERSISTENT_INTERVAL_MAP_H
+#define PERSISTENT_INTERVAL_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+// Versioned interval map: every assign yields a new version sharing all but
+// O(log n) boundary nodes with the previous one (a path-copying treap of
+// immutable nodes). snapshot() hands out the current version in O(1); a
+// version_view never changes however the map moves on, and may be read from
+// any thread. The map keeps every version since the last release_before()
+// for lookup_at(); a node is freed once no retained version or live view
+// reaches it. Writers need external synchronization.
+template<typename K, typename V>
+class persistent_interval_map {
+private:
+    struct node;
+    using node_ptr = std::shared_ptr<node const>;
+
+    struct node {
+        K key;
+        V val;
+        std::uint32_t priority;
+        std::size_t size;
+        node_ptr left;
+        node_ptr right;
+    };
+
+public:
+    using version_type = std::uint64_t;
+
+    // One version of the map, kept alive by the view itself
+    class version_view {
+    private:
+        friend class persistent_interval_map;
+        node_ptr m_root;
+        std::shared_ptr<V const> m_valBegin;
+        version_type m_version = 0;
+
+        version_view(node_ptr root, std::shared_ptr<V const> valBegin, version_type version);
+
+    public:
+        version_type version() const;
+        std::size_t size() const;
+        V const& get_begin_value() const;
+        V const& operator[](K const& key) const;
+        // Calls f(key, val) for each boundary in ascending key order
+        template<typename F>
+        void for_each_boundary(F&& f) const;
+    };
+
+    explicit persistent_interval_map(V const& val);
+
+    // Returns the version the assignment produced; an empty interval still
+    // produces one, identical to its predecessor
+    version_type assign(K const& keyBegin, K const& keyEnd, V const& val);
+
+    version_type version() const;
+    version_type oldest_version() const;
+    std::size_t size() const;
+    V const& get_begin_value() const;
+    V const& operator[](K const& key) const;
+
+    version_view snapshot() const;
+    // Throws std::out_of_range for versions released or not yet written
+    version_view at(version_type version) const;
+    V const& lookup_at(version_type version, K const& key) const;
+
+    // Drops the versions before version (at most the current one); views
+    // already handed out stay valid
+    void release_before(version_type version);
+
+private:
+    std::shared_ptr<V const> m_valBegin;
+    std::deque<node_ptr> m_history;     // roots of versions m_oldest onwards
+    version_type m_oldest = 0;
+    std::uint32_t m_seed = 2463534242u;
+
+    node_ptr const& root_at(version_type version) const;
+    node_ptr make_node(K const& key, V const& val);
+
+    static std::size_t size_of(node_ptr const& t);
+    static node_ptr with_children(node const& t, node_ptr left, node_ptr right);
+    static std::pair<node_ptr, node_ptr> split(node_ptr const& t, K const& key);
+    static node_ptr merge(node_ptr const& a, node_ptr const& b);
+    static node_ptr erase_min(node_ptr const& t);
+    static node const* min_node(node const* t);
+    static node const* max_node(node const* t);
+    static V const& value_at(node const* t, V const& valBegin, K const& key);
+    template<typename F>
+    static void visit(node const* t, F& f);
+};
+
+#include "persistent_interval_map_impl.h"
+
+#endif // PERSISTENT_INTERVAL_MAP_H
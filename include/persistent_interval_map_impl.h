@@ -0,0 +1,225 @@
+#ifndef PERSISTENT_INTERVAL_MAP_IMPL_H
+#define PERSISTENT_INTERVAL_MAP_IMPL_H
+
+#include "persistent_interval_map.h"
+#include <stdexcept>
+#include <string>
+
+template<typename K, typename V>
+persistent_interval_map<K, V>::version_view::version_view(node_ptr root, std::shared_ptr<V const> valBegin,
+                                                          version_type version)
+    : m_root(std::move(root)), m_valBegin(std::move(valBegin)), m_version(version) {}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_type persistent_interval_map<K, V>::version_view::version() const {
+    return m_version;
+}
+
+template<typename K, typename V>
+std::size_t persistent_interval_map<K, V>::version_view::size() const {
+    return size_of(m_root);
+}
+
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::version_view::get_begin_value() const {
+    return *m_valBegin;
+}
+
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::version_view::operator[](K const& key) const {
+    return value_at(m_root.get(), *m_valBegin, key);
+}
+
+template<typename K, typename V>
+template<typename F>
+void persistent_interval_map<K, V>::version_view::for_each_boundary(F&& f) const {
+    visit(m_root.get(), f);
+}
+
+template<typename K, typename V>
+persistent_interval_map<K, V>::persistent_interval_map(V const& val)
+    : m_valBegin(std::make_shared<V const>(val)), m_history(1) {}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_type
+persistent_interval_map<K, V>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    node_ptr const& root = m_history.back();
+    if (!(keyBegin < keyEnd)) {
+        m_history.push_back(root);
+        return version();
+    }
+
+    // Cut out [keyBegin, keyEnd); only the nodes on the two search paths are copied
+    auto [left, rest] = split(root, keyBegin);
+    auto [middle, right] = split(rest, keyEnd);
+
+    // The old root is still in the history, so val may refer into it; left,
+    // middle and right hold the copied search paths alive until the end
+    node const* before = max_node(left.get());
+    V const& valBefore = before ? before->val : *m_valBegin;
+    node const* after = min_node(right.get());
+    bool boundaryAtEnd = after && !(keyEnd < after->key);
+    node const* inside = max_node(middle.get());
+    V const& valEnd = boundaryAtEnd ? after->val : inside ? inside->val : valBefore;
+
+    node_ptr result = left;
+    if (!(valBefore == val)) {
+        result = merge(result, make_node(keyBegin, val));
+    }
+    node_ptr tail = right;
+    if (boundaryAtEnd) {
+        if (after->val == val) {
+            tail = erase_min(right);
+        }
+    } else if (!(valEnd == val)) {
+        result = merge(result, make_node(keyEnd, valEnd));
+    }
+    m_history.push_back(merge(result, tail));
+    return version();
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_type persistent_interval_map<K, V>::version() const {
+    return m_oldest + m_history.size() - 1;
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_type persistent_interval_map<K, V>::oldest_version() const {
+    return m_oldest;
+}
+
+template<typename K, typename V>
+std::size_t persistent_interval_map<K, V>::size() const {
+    return size_of(m_history.back());
+}
+
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::get_begin_value() const {
+    return *m_valBegin;
+}
+
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::operator[](K const& key) const {
+    return value_at(m_history.back().get(), *m_valBegin, key);
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_view persistent_interval_map<K, V>::snapshot() const {
+    return version_view(m_history.back(), m_valBegin, version());
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::version_view persistent_interval_map<K, V>::at(version_type version) const {
+    return version_view(root_at(version), m_valBegin, version);
+}
+
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::lookup_at(version_type version, K const& key) const {
+    return value_at(root_at(version).get(), *m_valBegin, key);
+}
+
+template<typename K, typename V>
+void persistent_interval_map<K, V>::release_before(version_type version) {
+    while (m_oldest < version && m_history.size() > 1) {
+        m_history.pop_front();
+        ++m_oldest;
+    }
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node_ptr const&
+persistent_interval_map<K, V>::root_at(version_type version) const {
+    if (version < m_oldest || version > this->version()) {
+        throw std::out_of_range("persistent_interval_map: version " + std::to_string(version) +
+                                " is not retained");
+    }
+    return m_history[version - m_oldest];
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node_ptr persistent_interval_map<K, V>::make_node(K const& key, V const& val) {
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return std::make_shared<node const>(node{key, val, m_seed, 1, nullptr, nullptr});
+}
+
+template<typename K, typename V>
+std::size_t persistent_interval_map<K, V>::size_of(node_ptr const& t) {
+    return t ? t->size : 0;
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node_ptr
+persistent_interval_map<K, V>::with_children(node const& t, node_ptr left, node_ptr right) {
+    std::size_t size = size_of(left) + 1 + size_of(right);
+    return std::make_shared<node const>(node{t.key, t.val, t.priority, size, std::move(left), std::move(right)});
+}
+
+// Splits t into keys < key and keys >= key, copying the search path
+template<typename K, typename V>
+std::pair<typename persistent_interval_map<K, V>::node_ptr, typename persistent_interval_map<K, V>::node_ptr>
+persistent_interval_map<K, V>::split(node_ptr const& t, K const& key) {
+    if (!t) return {};
+    if (t->key < key) {
+        auto [l, r] = split(t->right, key);
+        return {with_children(*t, t->left, std::move(l)), std::move(r)};
+    }
+    auto [l, r] = split(t->left, key);
+    return {std::move(l), with_children(*t, std::move(r), t->right)};
+}
+
+// Joins a and b where every key of a is below every key of b
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node_ptr persistent_interval_map<K, V>::merge(node_ptr const& a, node_ptr const& b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->priority > b->priority) {
+        return with_children(*a, a->left, merge(a->right, b));
+    }
+    return with_children(*b, merge(a, b->left), b->right);
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node_ptr persistent_interval_map<K, V>::erase_min(node_ptr const& t) {
+    if (!t->left) return t->right;
+    return with_children(*t, erase_min(t->left), t->right);
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node const* persistent_interval_map<K, V>::min_node(node const* t) {
+    while (t && t->left) t = t->left.get();
+    return t;
+}
+
+template<typename K, typename V>
+typename persistent_interval_map<K, V>::node const* persistent_interval_map<K, V>::max_node(node const* t) {
+    while (t && t->right) t = t->right.get();
+    return t;
+}
+
+// Value of the last boundary at or before key
+template<typename K, typename V>
+V const& persistent_interval_map<K, V>::value_at(node const* t, V const& valBegin, K const& key) {
+    V const* val = &valBegin;
+    while (t) {
+        if (key < t->key) {
+            t = t->left.get();
+        } else {
+            val = &t->val;
+            t = t->right.get();
+        }
+    }
+    return *val;
+}
+
+template<typename K, typename V>
+template<typename F>
+void persistent_interval_map<K, V>::visit(node const* t, F& f) {
+    if (!t) return;
+    visit(t->left.get(), f);
+    f(t->key, t->val);
+    visit(t->right.get(), f);
+}
+
+#endif // PERSISTENT_INTERVAL_MAP_IMPL_H
@@ -0,0 +1,49 @@
+#ifndef SHARDED_INTERVAL_MAP_H
+#define SHARDED_INTERVAL_MAP_H
+
+#include "interval_map.h"
+#include <cstddef>
+#include <memory>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+// interval_map split into contiguous key ranges, each with its own lock, so
+// writers touching different ranges proceed in parallel. Shard i owns
+// [splitters[i-1], splitters[i]); the first and last shards are unbounded.
+// An assign spanning several shards locks them in ascending order and is
+// applied to all of them atomically with respect to other operations.
+template<typename K, typename V, typename Storage = default_storage_t<K, V>>
+class sharded_interval_map {
+private:
+    struct shard {
+        mutable std::shared_mutex mutex;
+        interval_map<K, V, Storage> map;
+
+        explicit shard(V const& val) : map(val) {}
+    };
+
+    V m_valBegin;
+    std::vector<K> m_splitters;
+    std::vector<std::unique_ptr<shard>> m_shards;
+
+    std::size_t shard_of(K const& key) const;
+
+public:
+    // splitters must be strictly increasing; n splitters give n + 1 shards
+    sharded_interval_map(V const& val, std::vector<K> splitters);
+
+    std::size_t shard_count() const;
+    V const& get_begin_value() const;
+
+    void assign(K const& keyBegin, K const& keyEnd, V const& val);
+    V operator[](K const& key) const;
+
+    // Canonical (key, value) boundaries of the whole map; a shard seam only
+    // appears where the value actually changes
+    std::vector<std::pair<K, V>> boundaries() const;
+};
+
+#include "sharded_interval_map_impl.h"
+
+#endif // SHARDED_INTERVAL_MAP_H
@@ -0,0 +1,99 @@
+#ifndef SHARDED_INTERVAL_MAP_IMPL_H
+#define SHARDED_INTERVAL_MAP_IMPL_H
+
+#include "sharded_interval_map.h"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+template<typename K, typename V, typename Storage>
+sharded_interval_map<K, V, Storage>::sharded_interval_map(V const& val, std::vector<K> splitters)
+    : m_valBegin(val), m_splitters(std::move(splitters)) {
+    for (std::size_t i = 1; i < m_splitters.size(); ++i) {
+        if (!(m_splitters[i - 1] < m_splitters[i])) {
+            throw std::invalid_argument("sharded_interval_map: splitters must be strictly increasing");
+        }
+    }
+    for (std::size_t i = 0; i <= m_splitters.size(); ++i) {
+        m_shards.push_back(std::make_unique<shard>(val));
+    }
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t sharded_interval_map<K, V, Storage>::shard_of(K const& key) const {
+    return std::upper_bound(m_splitters.begin(), m_splitters.end(), key) - m_splitters.begin();
+}
+
+template<typename K, typename V, typename Storage>
+std::size_t sharded_interval_map<K, V, Storage>::shard_count() const {
+    return m_shards.size();
+}
+
+template<typename K, typename V, typename Storage>
+V const& sharded_interval_map<K, V, Storage>::get_begin_value() const {
+    return m_valBegin;
+}
+
+template<typename K, typename V, typename Storage>
+void sharded_interval_map<K, V, Storage>::assign(K const& keyBegin, K const& keyEnd, V const& val) {
+    if (!(keyBegin < keyEnd)) return;
+
+    // Each shard's map is exact inside its own range; the piece clipped to a
+    // shard's upper seam leaves at most one restoring boundary on the seam,
+    // which boundaries() never reports.
+    const std::size_t first = shard_of(keyBegin);
+    std::size_t last = shard_of(keyEnd);
+    if (last > first && !(m_splitters[last - 1] < keyEnd)) {
+        --last;  // keyEnd sits exactly on a seam
+    }
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    for (std::size_t i = first; i <= last; ++i) {
+        locks.emplace_back(m_shards[i]->mutex);
+    }
+    for (std::size_t i = first; i <= last; ++i) {
+        K const& pieceBegin = (i == first) ? keyBegin : m_splitters[i - 1];
+        K const& pieceEnd = (i == last) ? keyEnd : m_splitters[i];
+        m_shards[i]->map.assign(pieceBegin, pieceEnd, val);
+    }
+}
+
+template<typename K, typename V, typename Storage>
+V sharded_interval_map<K, V, Storage>::operator[](K const& key) const {
+    shard const& owner = *m_shards[shard_of(key)];
+    std::shared_lock<std::shared_mutex> lock(owner.mutex);
+    return owner.map[key];
+}
+
+template<typename K, typename V, typename Storage>
+std::vector<std::pair<K, V>> sharded_interval_map<K, V, Storage>::boundaries() const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    for (auto const& s : m_shards) {
+        locks.emplace_back(s->mutex);
+    }
+
+    std::vector<std::pair<K, V>> result;
+    auto emit = [&](K const& key, V const& val) {
+        V const& prev = result.empty() ? m_valBegin : result.back().second;
+        if (!(prev == val)) {
+            result.emplace_back(key, val);
+        }
+    };
+
+    for (std::size_t i = 0; i < m_shards.size(); ++i) {
+        auto const& map = m_shards[i]->map;
+        auto const& storage = map.get_storage();
+        auto it = storage.begin();
+        if (i > 0) {
+            // Re-emit the value in effect at the seam; emit() drops it when
+            // it continues the previous shard's last interval
+            emit(m_splitters[i - 1], map[m_splitters[i - 1]]);
+            it = storage.upper_bound(m_splitters[i - 1]);
+        }
+        for (; it != storage.end() && (i == m_splitters.size() || storage.key(it) < m_splitters[i]); ++it) {
+            emit(storage.key(it), storage.value(it));
+        }
+    }
+    return result;
+}
+
+#endif // SHARDED_INTERVAL_MAP_IMPL_H
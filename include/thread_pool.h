@@ -0,0 +1,153 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for data-parallel loops. Every worker owns a
+// task deque: it runs its own tasks newest first and, once they run out,
+// steals the oldest tasks of the others. parallel_for spreads its chunks
+// over the deques and lets the calling thread help until they are done, so
+// a pool of n threads runs n-1 workers.
+class thread_pool {
+private:
+    using task = std::function<void()>;
+
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<task_queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<std::size_t> m_queued{0};
+    std::atomic<std::size_t> m_nextQueue{0};
+    bool m_stopping = false;
+
+    void push(task t) {
+        task_queue& queue = *m_queues[m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(t));
+        }
+        // Counted under the sleep mutex so a worker about to wait sees it
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_queued.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_wake.notify_one();
+    }
+
+    // Runs one task: the newest of queue self, else the oldest of another
+    bool try_run(std::size_t self) {
+        task t;
+        std::size_t n = m_queues.size();
+        for (std::size_t k = 0; k < n && !t; ++k) {
+            std::size_t index = (self + k) % n;
+            task_queue& queue = *m_queues[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            if (k == 0 && self < n) {
+                t = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                t = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        if (!t) return false;
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        t();
+        return true;
+    }
+
+    void work(std::size_t self) {
+        for (;;) {
+            if (try_run(self)) continue;
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wake.wait(lock, [this] { return m_stopping || m_queued.load(std::memory_order_relaxed) > 0; });
+            if (m_stopping && m_queued.load(std::memory_order_relaxed) == 0) return;
+        }
+    }
+
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        std::size_t workers = std::max<std::size_t>(threads, 1) - 1;
+        for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i) {
+            m_queues.push_back(std::make_unique<task_queue>());
+        }
+        for (std::size_t i = 0; i < workers; ++i) {
+            m_workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    // Threads taking part in parallel_for, the caller included
+    std::size_t size() const { return m_workers.size() + 1; }
+
+    // Calls body(begin, end) for consecutive chunks of at most grain indices
+    // covering [0, n) and returns once all have run. The first exception a
+    // chunk throws is rethrown here after the others finish.
+    template<typename F>
+    void parallel_for(std::size_t n, std::size_t grain, F&& body) {
+        if (n == 0) return;
+        grain = std::max<std::size_t>(grain, 1);
+        if (m_workers.empty() || n <= grain) {
+            for (std::size_t begin = 0; begin < n; begin += grain) {
+                body(begin, std::min(n, begin + grain));
+            }
+            return;
+        }
+
+        std::atomic<std::size_t> remaining{(n + grain - 1) / grain};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        for (std::size_t begin = 0; begin < n; begin += grain) {
+            std::size_t end = std::min(n, begin + grain);
+            push([&, begin, end] {
+                try {
+                    body(begin, end);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+                remaining.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        // The caller steals like an idle worker until the last chunk finishes
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!try_run(m_queues.size())) {
+                std::this_thread::yield();
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,51 @@
+#include "interval_map_benchmark.h"
+#include "interval_map_workload.h"
+#include <stdexcept>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "usage: " << program << " [--workload NAME]... [--ops N] [--seed N] [--json PATH|-]\n"
+              << "       " << program << " --micro\n"
+              << "       " << program << " --list\n"
+              << "Runs seeded assign/lookup workloads (all of them by default); --micro runs the\n"
+              << "per-feature micro benchmarks instead." << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    workload_options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--micro") {
+            IntervalMapBenchmark::run_all_benchmarks();
+            return 0;
+        } else if (arg == "--list") {
+            for (const std::string& name : IntervalMapWorkloads::workload_names()) {
+                std::cout << name << std::endl;
+            }
+            return 0;
+        } else if (arg == "--workload" && has_value) {
+            options.workloads.push_back(argv[++i]);
+        } else if ((arg == "--ops" || arg == "--seed") && has_value) {
+            unsigned long long number;
+            try {
+                number = std::stoull(argv[++i]);
+            } catch (const std::logic_error&) {
+                print_usage(argv[0]);
+                return 2;
+            }
+            (arg == "--ops" ? options.operations : options.seed) = number;
+        } else if (arg == "--json" && has_value) {
+            options.json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    return IntervalMapWorkloads::run(options) ? 0 : 1;
+}
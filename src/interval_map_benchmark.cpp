@@ -0,0 +1,906 @@
+#include "interval_map_benchmark.h"
+#include "augmented_storage.h"
+#include "buffered_interval_map.h"
+#include "concurrent_interval_map.h"
+#include "interned_storage.h"
+#include "interval_map_combine.h"
+#include "interval_map_io.h"
+#include "interval_map_parallel.h"
+#include "interval_map_wal.h"
+#include "mapped_interval_map.h"
+#include "node_pool_resource.h"
+#include "persistent_interval_map.h"
+#include "sharded_interval_map.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+std::mt19937 IntervalMapBenchmark::gen(42);
+
+namespace {
+
+// Forwards to an upstream resource and counts the allocations it sees
+class counting_resource : public std::pmr::memory_resource {
+private:
+    std::pmr::memory_resource* m_upstream;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        return m_upstream->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    size_t allocations = 0;
+
+    explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : m_upstream(upstream) {}
+};
+
+} // namespace
+
+void IntervalMapBenchmark::run_all_benchmarks() {
+    bench_assign_scaling();
+    bench_batch_assign();
+    bench_buffered_writes();
+    bench_persistent_versions();
+    bench_combine();
+    bench_interned_assign();
+    bench_change_feed();
+    bench_from_sorted();
+    bench_snapshot_load();
+    bench_wal_replay();
+    bench_delimited_ingest();
+    bench_allocation_churn();
+    bench_memory_footprint();
+    bench_lookup_backends();
+    bench_batch_lookup();
+    bench_sorted_lookup();
+    bench_finger_locality();
+    bench_range_report();
+    bench_concurrent_reads();
+    bench_sharded_writes();
+    bench_parallel_scaling();
+}
+
+// Assignment Benchmarks
+void IntervalMapBenchmark::bench_assign_scaling() {
+    const int NUM_OPERATIONS = 200000;
+    const std::vector<size_t> sizes = {1000, 10000, 100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        interval_map<int, char> imap('A');
+        build_alternating(imap, boundaries);
+
+        // Short random overwrites keep the boundary count roughly stable,
+        // so any growth in cost comes from the map size alone
+        const int max_key = static_cast<int>(boundaries);
+        std::vector<int> starts(NUM_OPERATIONS);
+        for (int& start : starts) {
+            start = random_key(0, max_key);
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            imap.assign(starts[i], starts[i] + 1 + (i & 3), static_cast<char>('B' + (i & 1)));
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        print_result("assign", boundaries, ns / NUM_OPERATIONS);
+    }
+}
+
+void IntervalMapBenchmark::bench_batch_assign() {
+    const size_t BOUNDARIES = 1000000;
+    const std::vector<size_t> batch_sizes = {10000, 100000, 1000000};
+
+    for (size_t batch_size : batch_sizes) {
+        std::vector<interval_assignment<int, char>> batch(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            int start = random_key(0, static_cast<int>(BOUNDARIES));
+            batch[i] = {start, start + random_key(1, 64), static_cast<char>('B' + (i % 4))};
+        }
+
+        interval_map<int, char> sequential('A');
+        build_alternating(sequential, BOUNDARIES);
+        interval_map<int, char> batched(sequential);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (const auto& entry : batch) {
+            sequential.assign(entry.keyBegin, entry.keyEnd, entry.val);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        batched.assign_batch(batch);
+        auto end = std::chrono::steady_clock::now();
+
+        print_result("assign loop x" + std::to_string(batch_size), BOUNDARIES,
+                     std::chrono::duration<double, std::nano>(middle - begin).count() / batch_size);
+        print_result("assign_batch x" + std::to_string(batch_size), BOUNDARIES,
+                     std::chrono::duration<double, std::nano>(end - middle).count() / batch_size);
+    }
+}
+
+void IntervalMapBenchmark::bench_persistent_versions() {
+    const int NUM_OPERATIONS = 100000;
+    const int NUM_COPIES = 20;
+    const std::vector<size_t> sizes = {10000, 1000000};
+
+    for (size_t boundaries : sizes) {
+        interval_map<int, char> imap('A');
+        build_alternating(imap, boundaries);
+        persistent_interval_map<int, char> versioned('A');
+        for (size_t i = 0; i < boundaries / 2; ++i) {
+            int key = static_cast<int>(2 * i);
+            versioned.assign(key, key + 1, 'B');
+        }
+        versioned.release_before(versioned.version());
+        auto first = versioned.version();
+
+        std::vector<int> starts(NUM_OPERATIONS);
+        for (int& start : starts) {
+            start = random_key(0, static_cast<int>(boundaries));
+        }
+
+        // Every version stays retained while the writes go in
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            versioned.assign(starts[i], starts[i] + 1 + (i & 3), static_cast<char>('B' + (i & 1)));
+        }
+        auto end = std::chrono::steady_clock::now();
+        print_result("assign persistent", boundaries, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+
+        // A consistent copy for a long-running reader: whole map vs one version
+        begin = std::chrono::steady_clock::now();
+        size_t copied = 0;
+        for (int i = 0; i < NUM_COPIES; ++i) {
+            interval_map<int, char> copy(imap);
+            copied += copy.size();
+        }
+        end = std::chrono::steady_clock::now();
+        print_result("snapshot by copy", copied / NUM_COPIES, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_COPIES);
+
+        unsigned checksum = 0;
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            checksum += static_cast<unsigned>(versioned.snapshot().version());
+        }
+        end = std::chrono::steady_clock::now();
+        print_result("snapshot persistent", boundaries, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+
+        // Point-in-time lookups spread over the whole retained history
+        std::vector<persistent_interval_map<int, char>::version_type> versions(NUM_OPERATIONS);
+        for (auto& version : versions) {
+            version = first + random_key(0, NUM_OPERATIONS);
+        }
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            checksum += static_cast<unsigned char>(versioned.lookup_at(versions[i], starts[i]));
+        }
+        end = std::chrono::steady_clock::now();
+        print_result("lookup_at", boundaries, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+
+        // Keep the results observable so they are not optimized away
+        volatile unsigned sink = checksum;
+        (void)sink;
+    }
+}
+
+void IntervalMapBenchmark::bench_buffered_writes() {
+    const size_t BOUNDARIES = 1000000;
+    const int NUM_BURSTS = 2000;
+    const int BURST_SIZE = 64;
+    const int WINDOW = 2000;
+
+    // Each burst rewrites one hot window many times before a single read
+    std::vector<interval_assignment<int, char>> writes;
+    std::vector<int> reads;
+    for (int burst = 0; burst < NUM_BURSTS; ++burst) {
+        int window = random_key(0, static_cast<int>(BOUNDARIES) - WINDOW);
+        for (int i = 0; i < BURST_SIZE; ++i) {
+            int start = window + random_key(0, WINDOW / 2);
+            writes.push_back({start, start + random_key(1, WINDOW / 2), static_cast<char>('B' + (i & 3))});
+        }
+        reads.push_back(window + random_key(0, WINDOW));
+    }
+
+    auto run = [&](auto& imap) {
+        unsigned checksum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (int burst = 0; burst < NUM_BURSTS; ++burst) {
+            for (int i = 0; i < BURST_SIZE; ++i) {
+                const auto& write = writes[burst * BURST_SIZE + i];
+                imap.assign(write.keyBegin, write.keyEnd, write.val);
+            }
+            checksum += static_cast<unsigned char>(imap[reads[burst]]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        volatile unsigned sink = checksum;
+        (void)sink;
+        return std::chrono::duration<double, std::nano>(end - begin).count() / writes.size();
+    };
+
+    interval_map<int, char> eager('A');
+    build_alternating(eager, BOUNDARIES);
+    buffered_interval_map<int, char> buffered('A');
+    for (size_t i = 0; i < BOUNDARIES / 2; ++i) {
+        buffered.assign(static_cast<int>(2 * i), static_cast<int>(2 * i + 1), 'B');
+    }
+    buffered.flush();
+
+    print_result("burst assign eager", BOUNDARIES, run(eager));
+    print_result("burst assign buffered", BOUNDARIES, run(buffered));
+}
+
+void IntervalMapBenchmark::bench_combine() {
+    const size_t BOUNDARIES = 1000000;
+
+    interval_map<int, char> base('A');
+    build_alternating(base, BOUNDARIES);
+    interval_map<int, char> overrides('A');
+    for (size_t i = 0; i < BOUNDARIES / 2; ++i) {
+        int start = random_key(0, static_cast<int>(BOUNDARIES));
+        overrides.assign(start, start + random_key(1, 4), 'C');
+    }
+    auto overlay = [](char policy, char override_val) { return override_val == 'A' ? policy : override_val; };
+
+    // Overlay by assigning every override interval onto a copy of the base
+    auto begin = std::chrono::steady_clock::now();
+    {
+        interval_map<int, char> result(base);
+        const int from = 0, to = static_cast<int>(2 * BOUNDARIES);
+        for (const auto& [keyBegin, keyEnd, val] : overrides.intervals(from, to)) {
+            if (val != 'A') result.assign(keyBegin, keyEnd, val);
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    size_t boundaries = combine(base, overrides, overlay).size();
+    auto end = std::chrono::steady_clock::now();
+    combine(base, overrides, overlay, 4);
+    auto parallel_end = std::chrono::steady_clock::now();
+
+    // Cost per input boundary
+    const double inputs = static_cast<double>(base.size() + overrides.size());
+    print_result("overlay assign loop", boundaries,
+                 std::chrono::duration<double, std::nano>(middle - begin).count() / inputs);
+    print_result("overlay combine", boundaries, std::chrono::duration<double, std::nano>(end - middle).count() / inputs);
+    print_result("overlay combine 4 pieces", boundaries,
+                 std::chrono::duration<double, std::nano>(parallel_end - end).count() / inputs);
+}
+
+void IntervalMapBenchmark::bench_interned_assign() {
+    const size_t BOUNDARIES = 100000;
+
+    // Policy-like values: long strings, few distinct
+    std::vector<std::string> values;
+    for (int i = 0; i < 16; ++i) {
+        values.push_back("route:region-" + std::to_string(i) + "/policy=allow-internal-traffic-with-audit");
+    }
+
+    interval_map<int, std::string> plain(values[0]);
+    interval_map<int, std::string, interned_storage<int, std::string, interned_id_t<16>>> interned(values[0]);
+    print_result("assign string values", BOUNDARIES, time_heavy_assigns(plain, values, BOUNDARIES));
+    print_result("assign interned values", BOUNDARIES, time_heavy_assigns(interned, values, BOUNDARIES));
+}
+
+// Construction Benchmarks
+void IntervalMapBenchmark::bench_change_feed() {
+    const int NUM_OPERATIONS = 200000;
+    const std::vector<size_t> sizes = {1000, 100000, 1000000};
+
+    for (size_t boundaries : sizes) {
+        const int max_key = static_cast<int>(boundaries);
+        std::vector<int> starts(NUM_OPERATIONS);
+        for (int& start : starts) {
+            start = random_key(0, max_key);
+        }
+
+        // Wider overwrites so each assign reports several changed ranges
+        auto run = [&](auto&& assign) {
+            interval_map<int, char> imap('A');
+            build_alternating(imap, boundaries);
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                assign(imap, starts[i], starts[i] + 1 + (i & 15), static_cast<char>('B' + (i & 1)));
+            }
+            auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS;
+        };
+
+        size_t changed = 0;
+        print_result("assign", boundaries,
+                     run([](auto& imap, int b, int e, char v) { imap.assign(b, e, v); }));
+        print_result("assign with changes", boundaries, run([&](auto& imap, int b, int e, char v) {
+                         imap.assign(b, e, v, [&](int, int, char, char) { ++changed; });
+                     }));
+        volatile size_t sink = changed;
+        (void)sink;
+    }
+}
+
+void IntervalMapBenchmark::bench_from_sorted() {
+    const size_t BOUNDARIES = 10000000;
+    std::vector<std::pair<int, char>> boundaries(BOUNDARIES);
+    for (size_t i = 0; i < BOUNDARIES; ++i) {
+        boundaries[i] = {static_cast<int>(i), static_cast<char>('B' + (i & 1))};
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    {
+        interval_map<int, char> imap('A');
+        for (size_t i = 0; i + 1 < BOUNDARIES; ++i) {
+            imap.assign(boundaries[i].first, boundaries[i + 1].first, boundaries[i].second);
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    {
+        auto imap = interval_map<int, char>::from_sorted('A', boundaries.begin(), boundaries.end());
+    }
+    auto end = std::chrono::steady_clock::now();
+    {
+        auto imap = interval_map<int, char, flat_storage<int, char>>::from_sorted('A', boundaries.begin(), boundaries.end());
+    }
+    auto flat_end = std::chrono::steady_clock::now();
+
+    // Startup time per boundary, including teardown of the built map
+    print_result("startup assign loop", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(middle - begin).count() / BOUNDARIES);
+    print_result("startup from_sorted", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(end - middle).count() / BOUNDARIES);
+    print_result("startup from_sorted flat", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(flat_end - end).count() / BOUNDARIES);
+}
+
+void IntervalMapBenchmark::bench_snapshot_load() {
+    const size_t BOUNDARIES = 10000000;
+    const size_t NUM_LOOKUPS = 1000000;
+    const std::string path = (std::filesystem::temp_directory_path() / "interval_map_bench.snap").string();
+
+    std::vector<std::pair<int, char>> boundaries(BOUNDARIES);
+    for (size_t i = 0; i < BOUNDARIES; ++i) {
+        boundaries[i] = {static_cast<int>(i), static_cast<char>('B' + (i & 1))};
+    }
+    auto imap = interval_map<int, char, flat_storage<int, char>>::from_sorted('A', boundaries.begin(), boundaries.end());
+
+    auto begin = std::chrono::steady_clock::now();
+    save_snapshot(imap, path);
+    auto middle = std::chrono::steady_clock::now();
+    auto mapped = mapped_interval_map<int, char>::open(path);
+    auto end = std::chrono::steady_clock::now();
+
+    std::vector<int> keys(NUM_LOOKUPS);
+    for (int& key : keys) {
+        key = random_key(0, static_cast<int>(BOUNDARIES));
+    }
+    // The first pass faults the pages in; the second runs from the page cache
+    double cold = time_lookups(mapped, keys);
+    double warm = time_lookups(mapped, keys);
+    auto verify_begin = std::chrono::steady_clock::now();
+    bool intact = mapped.verify();
+    auto verify_end = std::chrono::steady_clock::now();
+    std::filesystem::remove(path);
+
+    print_result("snapshot save", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(middle - begin).count() / BOUNDARIES);
+    print_result("startup mapped open", BOUNDARIES, std::chrono::duration<double, std::nano>(end - middle).count());
+    print_result("mapped lookup cold", BOUNDARIES, cold);
+    print_result("mapped lookup warm", BOUNDARIES, warm);
+    print_result(intact ? "snapshot verify" : "snapshot verify FAILED", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(verify_end - verify_begin).count() / BOUNDARIES);
+}
+
+void IntervalMapBenchmark::bench_wal_replay() {
+    const int KEY_SPACE = 1000000;
+    const int NUM_OPERATIONS = 1000000;
+    const std::string directory = (std::filesystem::temp_directory_path() / "interval_map_bench_wal").string();
+    std::filesystem::remove_all(directory);
+
+    size_t logged = 0;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        interval_map_wal<int, char> wal(directory, 'A', {1024, 65536});
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            int start = random_key(0, KEY_SPACE);
+            wal.assign(start, start + random_key(1, 64), static_cast<char>('B' + (i & 3)));
+        }
+        logged = wal.map().size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    print_result("wal assign group 1024", logged, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+
+    // Recovery replays the whole log; batched replay against one assign per record
+    for (size_t replay_batch : {size_t(1), size_t(65536)}) {
+        auto replay_begin = std::chrono::steady_clock::now();
+        interval_map_wal<int, char> wal(directory, 'A', {1024, replay_batch});
+        auto replay_end = std::chrono::steady_clock::now();
+        size_t boundaries = wal.map().size();
+
+        double ns = std::chrono::duration<double, std::nano>(replay_end - replay_begin).count() / wal.replayed();
+        print_result(replay_batch == 1 ? "wal replay per record" : "wal replay batched", boundaries, ns);
+        std::cout << "  " << std::fixed << std::setprecision(0) << 1e9 / ns << " records/s" << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+}
+
+// Allocation Benchmarks
+void IntervalMapBenchmark::bench_delimited_ingest() {
+    const size_t ROWS = 4000000;
+    const std::string path = (std::filesystem::temp_directory_path() / "interval_map_bench.csv").string();
+
+    // What interval_map_tool --assign reads: random 64-bit intervals
+    {
+        std::mt19937_64 local_gen(7);
+        line_writer out(path);
+        for (size_t i = 0; i < ROWS; ++i) {
+            long long start = static_cast<long long>(local_gen() % 1000000000000);
+            out.write_fields(',', start, start + 1 + static_cast<long long>(local_gen() % 1000000),
+                             static_cast<long long>(local_gen() % 50));
+        }
+    }
+    const double megabytes = std::filesystem::file_size(path) / 1e6;
+
+    std::vector<interval_assignment<long long, long long>> batch;
+    batch.reserve(ROWS);
+    for (bool map : {false, true}) {
+        batch.clear();
+        auto begin = std::chrono::steady_clock::now();
+        line_reader reader(path, map);
+        std::string_view line;
+        interval_assignment<long long, long long> entry;
+        while (reader.next(line) && parse_fields(line, ',', entry.keyBegin, entry.keyEnd, entry.val)) {
+            batch.push_back(entry);
+        }
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - begin).count();
+        print_result(map ? "parse mmap" : "parse chunked", batch.size(), seconds * 1e9 / ROWS);
+        std::cout << "  " << std::fixed << std::setprecision(1) << megabytes / seconds << " MB/s" << std::endl;
+    }
+
+    interval_map<long long, long long> imap(0);
+    auto begin = std::chrono::steady_clock::now();
+    imap.assign_batch(batch);
+    auto end = std::chrono::steady_clock::now();
+    std::filesystem::remove(path);
+    print_result("ingest assign_batch", imap.size(), std::chrono::duration<double, std::nano>(end - begin).count() / ROWS);
+}
+
+void IntervalMapBenchmark::bench_allocation_churn() {
+    const size_t BOUNDARIES = 100000;
+    const int NUM_OPERATIONS = 1000000;
+
+    std::vector<int> starts(NUM_OPERATIONS);
+    for (int& start : starts) {
+        start = random_key(0, static_cast<int>(BOUNDARIES));
+    }
+
+    // Each assign inserts and erases boundary nodes at a steady live count
+    auto churn = [&](const std::string& name, std::pmr::memory_resource* resource, counting_resource& counter) {
+        pmr_interval_map<int, char> imap('A', resource);
+        build_alternating(imap, BOUNDARIES);
+        size_t warm = counter.allocations;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            imap.assign(starts[i], starts[i] + 1 + (i & 3), static_cast<char>('B' + (i & 1)));
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        print_result(name, BOUNDARIES, std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+        std::cout << std::setw(36) << (counter.allocations - warm) << " upstream allocations during churn" << std::endl;
+    };
+
+    counting_resource global_counter;
+    churn("churn new_delete", &global_counter, global_counter);
+
+    counting_resource pool_counter;
+    node_pool_resource pool(&pool_counter);
+    churn("churn node_pool", &pool, pool_counter);
+
+    counting_resource std_pool_counter;
+    std::pmr::unsynchronized_pool_resource std_pool(&std_pool_counter);
+    churn("churn std pool", &std_pool, std_pool_counter);
+}
+
+void IntervalMapBenchmark::bench_memory_footprint() {
+    const int NUM_OPERATIONS = 1000000;
+    const std::vector<size_t> sizes = {100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        std::vector<int> starts(NUM_OPERATIONS);
+        for (int& start : starts) {
+            start = random_key(0, static_cast<int>(boundaries));
+        }
+
+        // The churn of bench_assign_scaling, then the bytes each boundary costs
+        auto run = [&](const std::string& name, auto& imap) {
+            build_alternating(imap, boundaries);
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                imap.assign(starts[i], starts[i] + 1 + (i & 3), static_cast<char>('B' + (i & 1)));
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            print_result(name, imap.size(), std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS);
+            std::cout << std::setw(36) << std::setprecision(2)
+                      << static_cast<double>(imap.get_storage().memory_usage()) / imap.size()
+                      << " bytes per boundary" << std::endl;
+        };
+
+        interval_map<int, char, map_storage<int, char>> tree_map('A');
+        run("assign map_storage", tree_map);
+        interval_map<int, char, packed_storage<int, char>> packed_map('A');
+        run("assign packed_storage", packed_map);
+    }
+}
+
+// Lookup Benchmarks
+void IntervalMapBenchmark::bench_lookup_backends() {
+    const int NUM_LOOKUPS = 1000000;
+    const std::vector<size_t> sizes = {1000, 100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        interval_map<int, char, map_storage<int, char>> tree_map('A');
+        interval_map<int, char, packed_storage<int, char>> packed_map('A');
+        interval_map<int, char, flat_storage<int, char>> flat_map('A');
+        build_alternating(tree_map, boundaries);
+        build_alternating(packed_map, boundaries);
+        build_alternating(flat_map, boundaries);
+
+        std::vector<int> keys(NUM_LOOKUPS);
+        for (int& key : keys) {
+            key = random_key(0, static_cast<int>(boundaries));
+        }
+
+        print_result("lookup map_storage", boundaries, time_lookups(tree_map, keys));
+        print_result("lookup packed_storage", boundaries, time_lookups(packed_map, keys));
+        print_result("lookup flat_storage", boundaries, time_lookups(flat_map, keys));
+        print_result("lookup frozen", boundaries, time_lookups(tree_map.freeze(), keys));
+    }
+}
+
+void IntervalMapBenchmark::bench_batch_lookup() {
+    const int NUM_LOOKUPS = 1000000;
+    const std::vector<size_t> sizes = {1000, 100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        interval_map<int, char> imap('A');
+        build_alternating(imap, boundaries);
+        auto frozen = imap.freeze();
+
+        std::vector<int> keys(NUM_LOOKUPS);
+        for (int& key : keys) {
+            key = random_key(0, static_cast<int>(boundaries));
+        }
+        std::vector<char> out(keys.size());
+
+        auto begin = std::chrono::steady_clock::now();
+        frozen.lookup_batch(keys.data(), keys.size(), out.data());
+        auto end = std::chrono::steady_clock::now();
+
+        print_result("frozen operator[]", boundaries, time_lookups(frozen, keys));
+        print_result("frozen lookup_batch", boundaries,
+                     std::chrono::duration<double, std::nano>(end - begin).count() / keys.size());
+    }
+}
+
+void IntervalMapBenchmark::bench_sorted_lookup() {
+    const std::vector<size_t> sizes = {1000, 100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        interval_map<int, char> imap('A');
+        build_alternating(imap, boundaries);
+
+        // A dense address scan: every key of the populated range in order
+        std::vector<int> keys(boundaries);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keys[i] = static_cast<int>(i);
+        }
+        std::vector<char> out(keys.size());
+
+        auto begin = std::chrono::steady_clock::now();
+        imap.lookup_sorted(keys.begin(), keys.end(), out.begin());
+        auto end = std::chrono::steady_clock::now();
+
+        print_result("sorted operator[]", boundaries, time_lookups(imap, keys));
+        print_result("sorted lookup_sorted", boundaries,
+                     std::chrono::duration<double, std::nano>(end - begin).count() / keys.size());
+    }
+}
+
+void IntervalMapBenchmark::bench_finger_locality() {
+    const int NUM_OPERATIONS = 1000000;
+    const std::vector<size_t> sizes = {1000, 100000, 1000000, 10000000};
+
+    for (size_t boundaries : sizes) {
+        // A cursor wandering through the map: each step moves a few keys,
+        // overwrites a short interval and reads back next to it
+        std::vector<int> positions(NUM_OPERATIONS);
+        int pos = static_cast<int>(boundaries / 2);
+        for (int& p : positions) {
+            pos = std::clamp(pos + random_key(-8, 8), 0, static_cast<int>(boundaries));
+            p = pos;
+        }
+
+        auto run = [&](auto& imap, auto&& assign, auto&& lookup) {
+            build_alternating(imap, boundaries);
+            unsigned checksum = 0;
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < NUM_OPERATIONS; ++i) {
+                int key = positions[i];
+                assign(key, key + 1 + (i & 3), static_cast<char>('A' + (i & 1)));
+                checksum += static_cast<unsigned char>(lookup(key + 2));
+            }
+            auto end = std::chrono::steady_clock::now();
+            volatile unsigned sink = checksum;
+            (void)sink;
+            return std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS;
+        };
+
+        interval_map<int, char, map_storage<int, char>> tree_plain('A'), tree_hinted('A');
+        interval_map<int, char> packed_plain('A'), packed_hinted('A');
+        decltype(tree_hinted)::finger tree_hint;
+        decltype(packed_hinted)::finger packed_hint;
+
+        print_result("walk map plain", boundaries,
+                     run(tree_plain, [&](int b, int e, char v) { tree_plain.assign(b, e, v); },
+                         [&](int k) { return tree_plain[k]; }));
+        print_result("walk map finger", boundaries,
+                     run(tree_hinted, [&](int b, int e, char v) { tree_hinted.assign(tree_hint, b, e, v); },
+                         [&](int k) { return tree_hinted.lookup(tree_hint, k); }));
+        print_result("walk packed plain", boundaries,
+                     run(packed_plain, [&](int b, int e, char v) { packed_plain.assign(b, e, v); },
+                         [&](int k) { return packed_plain[k]; }));
+        print_result("walk packed finger", boundaries,
+                     run(packed_hinted, [&](int b, int e, char v) { packed_hinted.assign(packed_hint, b, e, v); },
+                         [&](int k) { return packed_hinted.lookup(packed_hint, k); }));
+    }
+}
+
+void IntervalMapBenchmark::bench_range_report() {
+    const size_t BOUNDARIES = 1000000;
+    const int RANGE_WIDTH = 100000;
+    const int NUM_REPORTS = 20;
+
+    interval_map<int, char> imap('A');
+    build_alternating(imap, BOUNDARIES);
+    std::vector<int> starts(NUM_REPORTS);
+    for (int& start : starts) {
+        start = random_key(0, static_cast<int>(BOUNDARIES) - RANGE_WIDTH);
+    }
+
+    // Report: number of keys mapped to 'B' in [start, start + RANGE_WIDTH)
+    long long per_key = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int start : starts) {
+        for (int key = start; key < start + RANGE_WIDTH; ++key) {
+            per_key += imap[key] == 'B';
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    long long per_interval = 0;
+    for (int start : starts) {
+        imap.for_each_interval(start, start + RANGE_WIDTH, [&per_interval](int keyBegin, int keyEnd, char val) {
+            if (val == 'B') per_interval += keyEnd - keyBegin;
+        });
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Same report from the subtree sums of augmented storage
+    interval_map<int, char, augmented_storage<int, char>> augmented('A');
+    build_alternating(augmented, BOUNDARIES);
+    unsigned long long per_aggregate = 0;
+    auto aggregate_begin = std::chrono::steady_clock::now();
+    for (int start : starts) {
+        per_aggregate += augmented.get_storage().count_value(start, start + RANGE_WIDTH, 'B');
+    }
+    auto aggregate_end = std::chrono::steady_clock::now();
+
+    volatile long long sink = per_key + per_interval + static_cast<long long>(per_aggregate);
+    (void)sink;
+    print_result("range report operator[]", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(middle - begin).count() / NUM_REPORTS);
+    print_result("range report intervals", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(end - middle).count() / NUM_REPORTS);
+    print_result("range report augmented", BOUNDARIES,
+                 std::chrono::duration<double, std::nano>(aggregate_end - aggregate_begin).count() / NUM_REPORTS);
+}
+
+// Concurrency Benchmarks
+void IntervalMapBenchmark::bench_concurrent_reads() {
+    const size_t BOUNDARIES = 100000;
+    const auto DURATION = std::chrono::milliseconds(300);
+    const std::vector<int> thread_counts = {1, 2, 4, 8};
+
+    for (int threads : thread_counts) {
+        concurrent_interval_map<int, char> cmap('A', 64, 256);
+        for (size_t i = 0; i < BOUNDARIES / 2; ++i) {
+            cmap.assign(static_cast<int>(2 * i), static_cast<int>(2 * i + 1), 'B');
+        }
+        cmap.publish();
+
+        std::atomic<bool> done{false};
+        std::atomic<size_t> total_reads{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t] {
+                auto reader = cmap.make_reader();
+                std::mt19937 local_gen(t);
+                std::uniform_int_distribution<> dis(0, static_cast<int>(BOUNDARIES));
+                size_t reads = 0;
+                unsigned checksum = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    checksum += static_cast<unsigned char>(reader[dis(local_gen)]);
+                    ++reads;
+                }
+                volatile unsigned sink = checksum;
+                (void)sink;
+                total_reads += reads;
+            });
+        }
+
+        // One writer keeps publishing small batches for the whole run
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; std::chrono::steady_clock::now() - begin < DURATION; ++i) {
+            int start = random_key(0, static_cast<int>(BOUNDARIES));
+            cmap.assign(start, start + 3, static_cast<char>('B' + (i & 3)));
+        }
+        done.store(true);
+        for (auto& thread : readers) {
+            thread.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // Wall time per read across all readers, i.e. inverse aggregate throughput
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        print_result("concurrent read x" + std::to_string(threads), BOUNDARIES, ns / total_reads.load());
+    }
+}
+
+void IntervalMapBenchmark::bench_sharded_writes() {
+    const int KEY_SPACE = 8000000;
+    const int SHARDS = 16;
+    const int OPERATIONS_PER_WRITER = 200000;
+    const std::vector<int> writer_counts = {1, 2, 4, 8};
+
+    std::vector<int> splitters;
+    for (int i = 1; i < SHARDS; ++i) {
+        splitters.push_back(i * (KEY_SPACE / SHARDS));
+    }
+
+    for (int writers : writer_counts) {
+        sharded_interval_map<int, char> smap('A', splitters);
+
+        // Each writer updates its own slice of the key space
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < writers; ++t) {
+            threads.emplace_back([&smap, t, writers] {
+                std::mt19937 local_gen(t);
+                const int slice = KEY_SPACE / writers;
+                std::uniform_int_distribution<> dis(t * slice, (t + 1) * slice - 64);
+                for (int i = 0; i < OPERATIONS_PER_WRITER; ++i) {
+                    int start = dis(local_gen);
+                    smap.assign(start, start + 1 + (i & 31), static_cast<char>('B' + (i & 3)));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        // Wall time per assign across all writers, i.e. inverse aggregate throughput
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        print_result("sharded assign x" + std::to_string(writers), smap.boundaries().size(),
+                     ns / (static_cast<double>(writers) * OPERATIONS_PER_WRITER));
+    }
+}
+
+void IntervalMapBenchmark::bench_parallel_scaling() {
+    const size_t BOUNDARIES = 1000000;
+    const size_t NUM_KEYS = 8000000;
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+
+    interval_map<int, char> imap('A');
+    build_alternating(imap, BOUNDARIES);
+    auto frozen = imap.freeze();
+    std::vector<int> keys(NUM_KEYS);
+    for (int& key : keys) {
+        key = random_key(0, static_cast<int>(BOUNDARIES));
+    }
+    std::vector<char> out(NUM_KEYS);
+    std::vector<std::pair<int, char>> boundaries;
+    for (size_t i = 0; i < 4 * BOUNDARIES; ++i) {
+        boundaries.emplace_back(static_cast<int>(2 * i), static_cast<char>('B' + (i / 3) % 2));
+    }
+
+    // Strong scaling: the same work on 1, 2, 4, ... threads up to the core count
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < hardware; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(hardware);
+
+    for (size_t threads : thread_counts) {
+        thread_pool pool(threads);
+        std::string suffix = " x" + std::to_string(threads);
+
+        auto begin = std::chrono::steady_clock::now();
+        parallel_lookup(imap, keys.data(), keys.size(), out.data(), pool);
+        auto middle = std::chrono::steady_clock::now();
+        parallel_lookup(frozen, keys.data(), keys.size(), out.data(), pool);
+        auto end = std::chrono::steady_clock::now();
+        print_result("parallel lookup" + suffix, BOUNDARIES, std::chrono::duration<double, std::nano>(middle - begin).count() / NUM_KEYS);
+        print_result("parallel frozen" + suffix, BOUNDARIES, std::chrono::duration<double, std::nano>(end - middle).count() / NUM_KEYS);
+
+        begin = std::chrono::steady_clock::now();
+        auto built = parallel_from_sorted<int, char>('A', boundaries.begin(), boundaries.end(), pool);
+        end = std::chrono::steady_clock::now();
+        print_result("parallel build" + suffix, built.size(),
+                     std::chrono::duration<double, std::nano>(end - begin).count() / boundaries.size());
+    }
+}
+
+// Helper Methods
+int IntervalMapBenchmark::random_key(int min, int max) {
+    std::uniform_int_distribution<> dis(min, max);
+    return dis(gen);
+}
+
+template<typename Storage>
+void IntervalMapBenchmark::build_alternating(interval_map<int, char, Storage>& imap, size_t boundaries) {
+    // [2i, 2i+1) -> 'B' on an 'A' background yields one boundary per key
+    for (size_t i = 0; i < boundaries / 2; ++i) {
+        int key = static_cast<int>(2 * i);
+        imap.assign(key, key + 1, 'B');
+    }
+}
+
+template<typename Map>
+double IntervalMapBenchmark::time_heavy_assigns(Map& imap, const std::vector<std::string>& values, size_t boundaries) {
+    const int NUM_OPERATIONS = 1000000;
+    std::mt19937 local_gen(7);
+    std::uniform_int_distribution<> key_dis(0, static_cast<int>(boundaries));
+    std::uniform_int_distribution<size_t> value_dis(0, values.size() - 1);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_OPERATIONS; ++i) {
+        int start = key_dis(local_gen);
+        imap.assign(start, start + 1 + (i & 7), values[value_dis(local_gen)]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / NUM_OPERATIONS;
+}
+
+template<typename Map>
+double IntervalMapBenchmark::time_lookups(const Map& imap, const std::vector<int>& keys) {
+    unsigned checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        checksum += static_cast<unsigned char>(imap[key]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Keep the lookups observable so they are not optimized away
+    volatile unsigned sink = checksum;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(end - begin).count() / keys.size();
+}
+
+void IntervalMapBenchmark::print_result(const std::string& name, size_t boundaries, double ns_per_op) {
+    std::cout << std::left << std::setw(24) << name
+              << std::right << std::setw(12) << boundaries << " boundaries"
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns_per_op << " ns/op" << std::endl;
+}
@@ -0,0 +1,139 @@
+#include "interval_map_io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void throw_errno(int error, std::string const& what) {
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+} // namespace
+
+line_reader::line_reader(std::string const& path, bool map, std::size_t chunkSize) : m_path(path) {
+    if (path == "-") {
+        m_fd = STDIN_FILENO;
+    } else {
+        m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_fd < 0) throw_errno(errno, "line_reader: cannot open " + path);
+        m_ownsFd = true;
+
+        struct stat info;
+        if (::fstat(m_fd, &info) != 0) {
+            int error = errno;
+            ::close(m_fd);
+            throw_errno(error, "line_reader: cannot stat " + path);
+        }
+        if (S_ISREG(info.st_mode)) {
+            m_size = static_cast<std::uint64_t>(info.st_size);
+        }
+    }
+
+    if (map && m_size > 0) {
+        void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (address == MAP_FAILED) {
+            int error = errno;
+            ::close(m_fd);
+            throw_errno(error, "line_reader: cannot map " + path);
+        }
+        ::madvise(address, m_size, MADV_SEQUENTIAL);
+        m_mapping = address;
+        m_mappingLength = m_size;
+        m_next = static_cast<char const*>(address);
+        m_end = m_next + m_size;
+        m_eof = true;
+        return;
+    }
+    // The buffer also holds the partial line carried over between chunks,
+    // and grows only for a line longer than a chunk
+    m_buffer.resize(std::max<std::size_t>(chunkSize, 64));
+    m_next = m_end = m_buffer.data();
+}
+
+line_reader::~line_reader() {
+    if (m_mapping) ::munmap(m_mapping, m_mappingLength);
+    if (m_ownsFd) ::close(m_fd);
+}
+
+// Moves the unread tail to the front of the buffer and reads after it
+bool line_reader::refill() {
+    if (m_eof) return false;
+    std::size_t tail = static_cast<std::size_t>(m_end - m_next);
+    std::memmove(m_buffer.data(), m_next, tail);
+    if (tail == m_buffer.size()) {
+        m_buffer.resize(m_buffer.size() * 2);
+    }
+    for (;;) {
+        ssize_t n = ::read(m_fd, m_buffer.data() + tail, m_buffer.size() - tail);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) throw_errno(errno, "line_reader: cannot read " + m_path);
+        m_next = m_buffer.data();
+        m_end = m_next + tail + static_cast<std::size_t>(n);
+        if (n == 0) m_eof = true;
+        return n > 0;
+    }
+}
+
+bool line_reader::next(std::string_view& line) {
+    char const* newline;
+    for (;;) {
+        newline = static_cast<char const*>(std::memchr(m_next, '\n', static_cast<std::size_t>(m_end - m_next)));
+        if (newline || !refill()) break;
+    }
+    if (!newline && m_next == m_end) return false;
+
+    // A final line without a terminator still counts
+    char const* lineEnd = newline ? newline : m_end;
+    line = std::string_view(m_next, static_cast<std::size_t>(lineEnd - m_next));
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    std::size_t length = static_cast<std::size_t>(lineEnd - m_next) + (newline ? 1 : 0);
+    m_consumed += length;
+    m_next += length;
+    ++m_line;
+    return true;
+}
+
+line_writer::line_writer(std::string const& path, std::size_t bufferSize)
+    : m_buffer(std::max<std::size_t>(bufferSize, 256)), m_path(path) {
+    if (path == "-") {
+        m_fd = STDOUT_FILENO;
+        return;
+    }
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (m_fd < 0) throw_errno(errno, "line_writer: cannot open " + path);
+    m_ownsFd = true;
+}
+
+line_writer::~line_writer() {
+    try {
+        flush();
+    } catch (...) {
+    }
+    if (m_ownsFd) ::close(m_fd);
+}
+
+void line_writer::put(std::string_view text) {
+    if (m_buffer.size() - m_used < text.size()) flush();
+    std::memcpy(m_buffer.data() + m_used, text.data(), text.size());
+    m_used += text.size();
+}
+
+void line_writer::flush() {
+    std::size_t done = 0;
+    while (done < m_used) {
+        ssize_t n = ::write(m_fd, m_buffer.data() + done, m_used - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) throw_errno(errno, "line_writer: cannot write " + m_path);
+        done += static_cast<std::size_t>(n);
+    }
+    m_written += m_used;
+    m_used = 0;
+}
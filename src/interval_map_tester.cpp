@@ -1,7 +1,33 @@
 #include "interval_map_tester.h"
+#include "augmented_storage.h"
+#include "buffered_interval_map.h"
+#include "concurrent_interval_map.h"
+#include "interned_storage.h"
+#include "interval_map_combine.h"
+#include "interval_map_io.h"
+#include "interval_map_parallel.h"
+#include "interval_map_wal.h"
+#include "mapped_interval_map.h"
+#include "node_pool_resource.h"
+#include "persistent_interval_map.h"
+#include "sharded_interval_map.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <set>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 
 std::random_device IntervalMapTester::rd;
 std::mt19937 IntervalMapTester::gen(IntervalMapTester::rd());
@@ -17,6 +43,30 @@ void IntervalMapTester::run_all_tests() {
         {"Overlapping Intervals", test_overlapping_intervals()},
         {"Adjacent Intervals", test_adjacent_intervals()},
         {"Boundary Conditions", test_boundary_conditions()},
+        {"Canonical Form", test_canonical_form()},
+        {"Flat Storage", test_flat_storage()},
+        {"Packed Storage", test_packed_storage()},
+        {"Interned Storage", test_interned_storage()},
+        {"Augmented Storage", test_augmented_storage()},
+        {"Frozen Lookup", test_frozen_lookup()},
+        {"PMR Allocation", test_pmr_allocation()},
+        {"Batch Lookup", test_batch_lookup()},
+        {"Sorted Lookup", test_sorted_lookup()},
+        {"Finger Hints", test_finger_hints()},
+        {"Change Feed", test_change_feed()},
+        {"Batch Assign", test_batch_assign()},
+        {"Buffered Writes", test_buffered_writes()},
+        {"From Sorted", test_from_sorted()},
+        {"Combine", test_combine()},
+        {"Snapshot Files", test_snapshot_files()},
+        {"Write-Ahead Log", test_write_ahead_log()},
+        {"Persistent Versions", test_persistent_versions()},
+        {"Delimited I/O", test_delimited_io()},
+        {"Concurrent Readers", test_concurrent_readers()},
+        {"Sharded Map", test_sharded_map()},
+        {"Parallel Bulk", test_parallel_bulk()},
+        {"Interval Iteration", test_interval_iteration()},
+        {"Stats", test_stats()},
         {"Random Intervals", test_random_intervals()},
         {"Large Operations", test_large_operations()},
         {"Memory Efficiency", test_memory_efficiency()}
@@ -211,22 +261,58 @@ bool IntervalMapTester::test_memory_efficiency() {
         interval_map<int, char> imap('A');
         const int NUM_OPERATIONS = 1000;
         
-        // Record initial memory usage
-        size_t initial_size = get_memory_usage(imap);
-        
         // Perform operations that should merge
         for (int i = 0; i < NUM_OPERATIONS; ++i) {
             imap.assign(i, i + 2, 'B');
             imap.assign(i + 1, i + 3, 'B');  // Should merge with previous
         }
         
-        // Record final memory usage
-        size_t final_size = get_memory_usage(imap);
-        
-        // Verify that memory usage is reasonable
-        // We expect much fewer nodes than operations due to merging
-        assert(final_size < NUM_OPERATIONS / 2);
-        
+        // We expect much fewer boundaries than operations due to merging
+        assert(imap.size() < NUM_OPERATIONS / 2);
+
+        // Counts what the storages actually request from their allocator
+        struct counting_resource : std::pmr::memory_resource {
+            size_t in_use = 0;
+            void* do_allocate(size_t bytes, size_t alignment) override {
+                in_use += bytes;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+                in_use -= bytes;
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+        };
+        using pmr_alloc = std::pmr::polymorphic_allocator<std::pair<const int, char>>;
+        counting_resource tree_bytes, packed_bytes;
+        interval_map<int, char, map_storage<int, char, pmr_alloc>> tree_map('A', &tree_bytes);
+        interval_map<int, char, packed_storage<int, char, pmr_alloc>> packed_map('A', &packed_bytes);
+
+        // Small trivially copyable keys and values get the packed layout by default
+        static_assert(std::is_same_v<interval_map<int, char>::storage_type, packed_storage<int, char>>);
+        static_assert(std::is_same_v<interval_map<int, std::string>::storage_type, map_storage<int, std::string>>);
+
+        // Many short random intervals: the boundaries barely merge
+        std::uniform_int_distribution<int> starts(0, 1 << 24);
+        for (int i = 0; i < 100000; ++i) {
+            int start = starts(gen);
+            int end = start + random_key(1, 64);
+            char val = static_cast<char>('B' + i % 16);
+            tree_map.assign(start, end, val);
+            packed_map.assign(start, end, val);
+        }
+        assert(tree_map.size() == packed_map.size() && tree_map.size() > 100000);
+
+        // memory_usage() is byte-accurate for the packed blocks, and for
+        // tree nodes where their layout is known
+#ifdef __GLIBCXX__
+        assert(tree_map.get_storage().memory_usage() == tree_bytes.in_use);
+#endif
+        assert(packed_map.get_storage().memory_usage() == packed_bytes.in_use);
+
+        // A tree node per boundary costs several times the packed blocks
+        assert(get_memory_usage(tree_map) >= 5 * get_memory_usage(packed_map));
+
         return true;
     } catch (...) {
         return false;
@@ -297,6 +383,1364 @@ bool IntervalMapTester::test_boundary_conditions() {
     }
 }
 
+bool IntervalMapTester::test_canonical_form() {
+    try {
+        // val may refer to a boundary the assignment removes
+        interval_map<int, std::string> strings("a");
+        const std::string wide(40, 'b');
+        strings.assign(10, 20, wide);
+        strings.assign(5, 15, strings[12]);
+        assert(strings[4] == "a" && strings[5] == wide && strings[19] == wide && strings[20] == "a");
+
+        interval_map<int, char> imap('A');
+        const int DOMAIN = 64;
+        std::vector<char> reference(DOMAIN, 'A');
+
+        // Compare against a brute-force model after every assignment
+        for (int i = 0; i < 5000; ++i) {
+            int start = random_key(0, DOMAIN - 1);
+            int end = random_key(0, DOMAIN - 1);
+            char val = static_cast<char>('A' + random_key(0, 3));
+            imap.assign(start, end, val);
+            for (int k = start; k < end; ++k) {
+                reference[k] = val;
+            }
+
+            for (int k = 0; k < DOMAIN; ++k) {
+                assert(imap[k] == reference[k]);
+            }
+            verify_canonical(imap);
+        }
+
+        // Overwriting with the begin value leaves no boundaries behind
+        imap.assign(-1, DOMAIN + 1, 'A');
+        assert(imap.size() == 0);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_flat_storage() {
+    try {
+        interval_map<int, char, map_storage<int, char>> tree_map('A');
+        interval_map<int, char, flat_storage<int, char>> flat_map('A');
+
+        // Both backends must hold identical boundaries after the same assignments
+        for (int i = 0; i < 2000; ++i) {
+            int start = random_key(-200, 200);
+            int end = start + random_key(0, 40);
+            char val = static_cast<char>('A' + random_key(0, 4));
+            tree_map.assign(start, end, val);
+            flat_map.assign(start, end, val);
+            assert(tree_map.size() == flat_map.size());
+        }
+        verify_canonical(flat_map);
+
+        auto flat_it = flat_map.get_storage().begin();
+        for (const auto& [key, val] : tree_map.get_storage()) {
+            const auto& [flat_key, flat_val] = *flat_it++;
+            assert(key == flat_key);
+            assert(val == flat_val);
+        }
+
+        for (int key = -250; key < 250; ++key) {
+            assert(tree_map[key] == flat_map[key]);
+        }
+
+        // A value read from the map stays valid while the arrays shift
+        interval_map<int, std::string, flat_storage<int, std::string>> strings("a");
+        const std::string wide(40, 'b');
+        strings.assign(10, 20, wide);
+        strings.assign(30, 40, "c");
+        strings.assign(5, 35, strings[12]);
+        strings.assign(0, 8, strings[36]);
+        assert(strings[0] == "c" && strings[8] == wide && strings[35] == "c" && strings[40] == "a");
+        assert(strings.size() == 4);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_packed_storage() {
+    try {
+        interval_map<int, char, map_storage<int, char>> tree_map('A');
+        interval_map<int, char, packed_storage<int, char>> packed_map('A');
+
+        // Narrow ranges churn single leaves; wide ones split, rebalance and
+        // merge across many
+        for (int i = 0; i < 20000; ++i) {
+            int width = i % 3 == 0 ? 3000 : 30;
+            int start = random_key(-20000, 20000);
+            int end = start + random_key(0, width);
+            char val = static_cast<char>('A' + random_key(0, 5));
+            tree_map.assign(start, end, val);
+            packed_map.assign(start, end, val);
+            assert(tree_map.size() == packed_map.size());
+        }
+        verify_canonical(packed_map);
+
+        const auto& storage = packed_map.get_storage();
+        assert(std::equal(tree_map.get_storage().begin(), tree_map.get_storage().end(), storage.begin(),
+                          [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; }));
+        size_t backwards = 0;
+        for (auto it = storage.end(); it != storage.begin(); ++backwards) {
+            --it;
+        }
+        assert(backwards == storage.size());
+        for (int key = -21000; key < 21000; ++key) {
+            assert(tree_map[key] == packed_map[key]);
+        }
+
+        // A value read from the map stays valid while blocks shift under it
+        for (int i = 0; i < 2000; ++i) {
+            int start = random_key(-20000, 20000);
+            int from = random_key(-20000, 20000);
+            tree_map.assign(start, start + 7, tree_map[from]);
+            packed_map.assign(start, start + 7, packed_map[from]);
+        }
+        assert(tree_map.size() == packed_map.size());
+
+        // Copies are rebuilt with full leaves
+        interval_map<int, char, packed_storage<int, char>> copy(packed_map);
+        assert(copy.size() == packed_map.size());
+        assert(copy.get_storage().memory_usage() <= packed_map.get_storage().memory_usage());
+        for (int key = -21000; key < 21000; key += 3) {
+            assert(copy[key] == packed_map[key]);
+        }
+
+        // Sorted builds fill every leaf
+        std::vector<std::pair<long long, char>> boundaries;
+        for (long long key = 0; key < 100000; ++key) {
+            boundaries.emplace_back(key * 3, static_cast<char>('B' + key % 2));
+        }
+        auto built = interval_map<long long, char>::from_sorted('A', boundaries.begin(), boundaries.end());
+        assert(built.get_storage().memory_usage() < boundaries.size() * 2 * sizeof(long long));
+        assert(built[299997] == 'B' + 99999 % 2 && built[-1] == 'A');
+
+        // Covering everything with the begin value empties the tree
+        packed_map.assign(-30000, 30000, 'A');
+        assert(packed_map.size() == 0 && packed_map.get_storage().memory_usage() == 0);
+        packed_map.assign(1, 2, 'B');
+        assert(packed_map[1] == 'B' && packed_map[2] == 'A');
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_interned_storage() {
+    try {
+        const std::vector<std::string> policies = {"allow", "deny", "redirect:eu-west", "redirect:us-east", "audit"};
+        interval_map<int, std::string> plain("allow");
+        interval_map<int, std::string, interned_storage<int, std::string, interned_id_t<8>>> interned("allow");
+        interval_map<int, std::string, interned_storage<int, std::string, std::uint16_t, flat_storage<int, std::uint16_t>>>
+            interned_flat("allow");
+
+        for (int i = 0; i < 2000; ++i) {
+            int start = random_key(-500, 500);
+            int end = start + random_key(0, 60);
+            const std::string& val = policies[random_key(0, 4)];
+            plain.assign(start, end, val);
+            interned.assign(start, end, val);
+            interned_flat.assign(start, end, val);
+        }
+
+        // Same canonical boundaries, but each distinct value is stored once
+        assert(interned.size() == plain.size());
+        assert(interned_flat.size() == plain.size());
+        assert(interned.get_storage().distinct_values() <= policies.size());
+        for (int key = -600; key < 600; ++key) {
+            assert(interned[key] == plain[key]);
+            assert(interned_flat[key] == plain[key]);
+        }
+
+        // Values are numbered by the id type; exceeding it is an error
+        interval_map<int, int, interned_storage<int, int, std::uint8_t>> narrow(0);
+        bool thrown = false;
+        try {
+            for (int i = 0; i < 300; ++i) {
+                narrow.assign(i, i + 1, i);
+            }
+        } catch (const std::length_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(narrow[255] == 255);
+
+        // The table holds the only copy of each value; the index points into it
+        auto shared = std::make_shared<const int>(7);
+        interval_map<int, std::shared_ptr<const int>, interned_storage<int, std::shared_ptr<const int>>> owners(nullptr);
+        owners.assign(0, 10, shared);
+        owners.assign(20, 30, shared);
+        assert(shared.use_count() == 2 && owners.get_storage().distinct_values() == 2);
+
+        // A copy indexes its own table, so it outlives the original
+        using interned_map = interval_map<int, std::string, interned_storage<int, std::string>>;
+        auto original = std::make_unique<interned_map>("allow");
+        original->assign(0, 10, "deny");
+        interned_map copy(*original);
+        original.reset();
+        copy.assign(5, 15, "deny");
+        copy.assign(20, 30, "audit");
+        assert(copy[0] == "deny" && copy[14] == "deny" && copy[15] == "allow" && copy[25] == "audit");
+        assert(copy.size() == 4 && copy.get_storage().distinct_values() == 3);
+
+        // Freezing reads values, not the ids the boundaries hold
+        interval_map<int, char, interned_storage<int, char, std::uint8_t>> letters('A');
+        letters.assign(0, 10, 'D');
+        letters.assign(5, 20, 'B');
+        frozen_interval_map<int, char> frozen = letters.freeze();
+        std::vector<int> probes = {-1, 0, 4, 5, 19, 20};
+        std::vector<char> answers(probes.size());
+        frozen.lookup_batch(probes.data(), probes.size(), answers.data());
+        for (std::size_t i = 0; i < probes.size(); ++i) {
+            assert(frozen[probes[i]] == letters[probes[i]] && answers[i] == letters[probes[i]]);
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_augmented_storage() {
+    try {
+        interval_map<int, char, augmented_storage<int, char>> imap('A');
+        assert(imap.get_storage().measure(-100, 100) == 0);
+        assert(imap.get_storage().count_value(-100, 100, 'A') == 200);
+
+        // Reference answers come from a plain walk over every key
+        auto check = [&imap](int a, int b) {
+            const auto& storage = imap.get_storage();
+            unsigned long long covered = 0;
+            unsigned long long counts[4] = {};
+            for (int key = a; key < b; ++key) {
+                char val = imap[key];
+                if (val != 'A') ++covered;
+                ++counts[val - 'A'];
+            }
+            assert(storage.measure(a, b) == covered);
+            for (char val = 'A'; val <= 'D'; ++val) {
+                assert(storage.count_value(a, b, val) == counts[val - 'A']);
+            }
+        };
+
+        for (int i = 0; i < 500; ++i) {
+            int start = random_key(-200, 200);
+            int end = start + random_key(0, 40);
+            imap.assign(start, end, static_cast<char>('A' + random_key(0, 3)));
+            if (i % 25 == 0) {
+                int a = random_key(-300, 300);
+                check(a, a + random_key(0, 200));
+            }
+        }
+        verify_canonical(imap);
+        check(-300, 300);
+        check(-100000, -250);
+
+        // kth_covered enumerates the covered keys in ascending order
+        unsigned long long k = 0;
+        for (int key = -300; key < 300; ++key) {
+            if (imap[key] != 'A') {
+                assert(imap.get_storage().kth_covered(k++) == key);
+            }
+        }
+        bool thrown = false;
+        try {
+            imap.get_storage().kth_covered(k);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // Coverage resumes after a gap of default keys
+        imap.assign(1000, std::numeric_limits<int>::max(), 'B');
+        assert(imap.get_storage().kth_covered(k) == 1000);
+        assert(imap.get_storage().count_value(900, 1100, 'B') == 100);
+
+        // from_sorted and copies carry their own length trees
+        using augmented_map = interval_map<int, char, augmented_storage<int, char>>;
+        std::vector<std::pair<int, char>> boundaries = {{0, 'B'}, {10, 'C'}, {20, 'A'}, {30, 'B'}, {40, 'A'}};
+        augmented_map built = augmented_map::from_sorted('A', boundaries.begin(), boundaries.end());
+        assert(built.get_storage().measure(-10, 50) == 30);
+        assert(built.get_storage().count_value(0, 50, 'B') == 20);
+        augmented_map copy(built);
+        built.assign(0, 40, 'A');
+        assert(built.get_storage().measure(-10, 50) == 0);
+        assert(copy.get_storage().measure(-10, 50) == 30 && copy.get_storage().kth_covered(25) == 35);
+        copy.assign(35, 45, 'C');
+        assert(copy.get_storage().count_value(0, 50, 'C') == 20 && copy.get_storage().measure(0, 50) == 35);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_frozen_lookup() {
+    try {
+        // An empty map freezes to its begin value everywhere
+        interval_map<int, char> imap('A');
+        auto empty = imap.freeze();
+        assert(empty[std::numeric_limits<int>::min()] == 'A');
+        assert(empty[std::numeric_limits<int>::max()] == 'A');
+
+        // Grow through non-power-of-two sizes so padding is exercised
+        for (int i = 0; i < 300; ++i) {
+            int start = random_key(-1000, 1000);
+            int end = start + random_key(1, 50);
+            imap.assign(start, end, static_cast<char>('B' + (i % 7)));
+
+            auto frozen = imap.freeze();
+            assert(frozen.size() == imap.size());
+            assert(frozen[std::numeric_limits<int>::min()] == imap[std::numeric_limits<int>::min()]);
+            assert(frozen[std::numeric_limits<int>::max()] == imap[std::numeric_limits<int>::max()]);
+            for (int key = -1100; key < 1100; key += 1 + i % 5) {
+                assert(frozen[key] == imap[key]);
+            }
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_pmr_allocation() {
+    try {
+        // A fixed arena with no fallback: any allocation beyond it throws
+        static std::byte arena[1 << 16];
+        std::pmr::monotonic_buffer_resource bounded(arena, sizeof(arena), std::pmr::null_memory_resource());
+        node_pool_resource pool(&bounded);
+
+        // Heavy churn with few live boundaries only fits if nodes are recycled
+        pmr_interval_map<int, char> imap('A', &pool);
+        for (int i = 0; i < 100000; ++i) {
+            int start = random_key(0, 100);
+            imap.assign(start, start + random_key(1, 10), static_cast<char>('B' + (i % 3)));
+            if (i % 1000 == 0) {
+                imap.assign(-1, 200, 'A');
+            }
+        }
+        assert(pool.block_size() > 0);
+        verify_canonical(imap);
+
+        // flat_storage takes a polymorphic allocator too
+        std::pmr::monotonic_buffer_resource arena_resource;
+        interval_map<int, char, flat_storage<int, char, std::pmr::polymorphic_allocator<char>>> flat_map('A', &arena_resource);
+        flat_map.assign(0, 10, 'B');
+        assert(flat_map[5] == 'B');
+        assert(flat_map[10] == 'A');
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_batch_lookup() {
+    try {
+        interval_map<int, char> imap('A');
+        interval_map<unsigned, char> umap('A');
+        interval_map<long long, char> lmap('A');
+
+        // Sizes straddle the vector width and the chunk size of the kernels
+        for (int round = 0; round < 6; ++round) {
+            for (int i = 0; i < (1 << (2 * round)); ++i) {
+                int start = random_key(-100000, 100000);
+                int end = start + random_key(1, 500);
+                char val = static_cast<char>('B' + (i % 11));
+                imap.assign(start, end, val);
+                umap.assign(static_cast<unsigned>(start) + 2147400000u, static_cast<unsigned>(end) + 2147400000u, val);
+                lmap.assign(start, end, val);
+            }
+
+            const size_t n = 1000 + round;
+            std::vector<int> keys(n);
+            std::vector<unsigned> ukeys(n);
+            std::vector<long long> lkeys(n);
+            for (size_t i = 0; i < n; ++i) {
+                keys[i] = random_key(-110000, 110000);
+                ukeys[i] = static_cast<unsigned>(keys[i]) + 2147400000u;
+                lkeys[i] = keys[i];
+            }
+            keys[0] = std::numeric_limits<int>::min();
+            keys[1] = std::numeric_limits<int>::max();
+
+            std::vector<char> out(n), uout(n), lout(n), mout(n);
+            imap.freeze().lookup_batch(keys.data(), n, out.data());
+            umap.freeze().lookup_batch(ukeys.data(), n, uout.data());
+            lmap.freeze().lookup_batch(lkeys.data(), n, lout.data());
+            imap.lookup_batch(keys.data(), n, mout.data());
+            for (size_t i = 0; i < n; ++i) {
+                assert(out[i] == imap[keys[i]]);
+                assert(uout[i] == umap[ukeys[i]]);
+                assert(lout[i] == lmap[lkeys[i]]);
+                assert(mout[i] == imap[keys[i]]);
+            }
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_sorted_lookup() {
+    try {
+        interval_map<int, char> tree_map('A');
+        interval_map<int, char, flat_storage<int, char>> flat_map('A');
+        for (int i = 0; i < 500; ++i) {
+            int start = random_key(-5000, 5000);
+            int end = start + random_key(1, 100);
+            char val = static_cast<char>('B' + (i % 9));
+            tree_map.assign(start, end, val);
+            flat_map.assign(start, end, val);
+        }
+
+        // Dense scan with repeated keys, then sparse jumps that force galloping
+        std::vector<int> keys;
+        for (int key = -5200; key < 5200; key += random_key(0, 3)) {
+            keys.push_back(key);
+        }
+        for (int key = -1000000; key < 1000000; key += random_key(1, 200000)) {
+            keys.push_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<char> tree_out, flat_out;
+        tree_map.lookup_sorted(keys.begin(), keys.end(), std::back_inserter(tree_out));
+        flat_map.lookup_sorted(keys.begin(), keys.end(), std::back_inserter(flat_out));
+        assert(tree_out.size() == keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            assert(tree_out[i] == tree_map[keys[i]]);
+            assert(flat_out[i] == tree_map[keys[i]]);
+        }
+
+        // A cursor serves the same stream one key at a time
+        interval_map<int, char>::sorted_cursor cursor(tree_map);
+        for (int key = -6000; key < 6000; key += 37) {
+            assert(cursor.seek(key) == tree_map[key]);
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_finger_hints() {
+    try {
+        using tree_map_type = interval_map<int, char, map_storage<int, char>>;
+        interval_map<int, char> plain('A');
+        interval_map<int, char> packed('A');
+        tree_map_type tree('A');
+        interval_map<int, char>::finger packed_hint;
+        tree_map_type::finger tree_hint;
+
+        // A random walk keeps most operations near the previous one, with
+        // the odd jump far away
+        int pos = 0;
+        for (int i = 0; i < 20000; ++i) {
+            pos = (i % 500 == 0) ? random_key(-5000, 5000) : std::clamp(pos + random_key(-40, 40), -5000, 5000);
+            int end = pos + random_key(-3, 30);
+            char val = static_cast<char>('A' + random_key(0, 4));
+            plain.assign(pos, end, val);
+            packed.assign(packed_hint, pos, end, val);
+            tree.assign(tree_hint, pos, end, val);
+
+            int key = pos + random_key(-50, 50);
+            assert(packed.lookup(packed_hint, key) == plain[key]);
+            assert(tree.lookup(tree_hint, key) == plain[key]);
+        }
+        assert(packed.size() == plain.size() && tree.size() == plain.size());
+        verify_canonical(packed);
+        verify_canonical(tree);
+        for (int key = -5100; key < 5100; ++key) {
+            assert(packed[key] == plain[key] && tree[key] == plain[key]);
+        }
+
+        // A hint is ignored once another modification may have moved its
+        // boundaries
+        interval_map<int, char>::finger other;
+        packed.lookup(packed_hint, 100);
+        packed.assign(other, 90, 110, 'Z');
+        plain.assign(90, 110, 'Z');
+        assert(packed.lookup(packed_hint, 100) == 'Z');
+        assert(packed.lookup(packed_hint, 150) == plain[150]);
+        packed.assign(packed_hint, 200, 100, 'Y');
+        assert(packed.lookup(packed_hint, 150) == plain[150]);
+        packed.clear();
+        assert(packed.lookup(packed_hint, 100) == 'A');
+
+        // A hint taken from another map, even a copy, is not trusted either
+        interval_map<int, char> copy(plain);
+        interval_map<int, char>::finger foreign;
+        plain.lookup(foreign, 0);
+        copy.assign(foreign, -10, 10, 'Q');
+        assert(copy[0] == 'Q' && plain[0] != 'Q');
+        for (int key = 20; key < 2000; key += 7) {
+            assert(copy.lookup(foreign, key) == plain[key]);
+        }
+
+        // Nor is one outliving its map when another is built in the same
+        // place and brought to the same epoch
+        std::optional<tree_map_type> slot;
+        tree_map_type::finger orphan;
+        slot.emplace('A');
+        const tree_map_type* first = &*slot;
+        for (int i = 0; i < 50; ++i) slot->assign(i * 10, i * 10 + 5, 'B');
+        assert(slot->lookup(orphan, 252) == 'B');
+        slot.reset();
+        slot.emplace('A');
+        assert(&*slot == first);
+        for (int i = 0; i < 50; ++i) slot->assign(i * 10 + 1, i * 10 + 4, 'C');
+        assert(slot->lookup(orphan, 252) == 'C' && slot->lookup(orphan, 250) == 'A');
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_change_feed() {
+    try {
+        const int lo = -600, hi = 600;
+        interval_map<int, char> packed('A');
+        interval_map<int, char, map_storage<int, char>> tree('A');
+        std::vector<char> shadow(hi - lo, 'A');
+
+        for (int i = 0; i < 3000; ++i) {
+            int start = random_key(lo + 50, hi - 150);
+            int end = start + random_key(-5, 100);
+            char val = static_cast<char>('A' + random_key(0, 3));
+
+            // Applying the reported changes to the old contents must give the
+            // new ones, touching only keys whose value really changes
+            std::vector<std::tuple<int, int, char, char>> changes, tree_changes;
+            packed.assign(start, end, val, [&](int b, int e, char old_val, char new_val) {
+                changes.emplace_back(b, e, old_val, new_val);
+            });
+            tree.assign(start, end, val, [&](int b, int e, char old_val, char new_val) {
+                tree_changes.emplace_back(b, e, old_val, new_val);
+            });
+            assert(changes == tree_changes);
+
+            std::vector<char> expected = shadow;
+            for (int key = std::max(start, lo); key < std::min(end, hi); ++key) {
+                expected[key - lo] = val;
+            }
+            int previous_end = start;
+            char previous_old = val;
+            for (const auto& [b, e, old_val, new_val] : changes) {
+                assert(previous_end <= b && b < e && e <= end && new_val == val && old_val != val);
+                // Maximal: touching ranges differ in their old value
+                assert(previous_end < b || previous_old != old_val);
+                for (int key = b; key < e; ++key) {
+                    assert(shadow[key - lo] == old_val);
+                    shadow[key - lo] = new_val;
+                }
+                previous_end = e;
+                previous_old = old_val;
+            }
+            assert(shadow == expected);
+            for (int key = lo; key < hi; ++key) {
+                assert(packed[key] == shadow[key - lo]);
+            }
+        }
+
+        // Reassigning what is already there reports nothing
+        bool reported = false;
+        auto note = [&](int, int, char, char) { reported = true; };
+        packed.assign(0, 10, 'Q');
+        packed.assign(2, 8, 'Q', note);
+        packed.assign(10, 5, 'Z', note);
+        assert(!reported);
+        verify_canonical(packed);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_batch_assign() {
+    try {
+        interval_map<int, char> sequential('A');
+        interval_map<int, char> batched('A');
+        interval_map<int, char, flat_storage<int, char>> flat_batched('A');
+
+        // Batch sizes cover both the per-segment and the full-merge paths
+        for (int round = 0; round < 40; ++round) {
+            std::vector<interval_assignment<int, char>> batch;
+            int batch_size = (round % 4 == 0) ? 500 : random_key(0, 8);
+            for (int i = 0; i < batch_size; ++i) {
+                int start = random_key(-2000, 2000);
+                int end = start + random_key(-5, 300);
+                batch.push_back({start, end, static_cast<char>('A' + random_key(0, 5))});
+            }
+
+            for (const auto& entry : batch) {
+                sequential.assign(entry.keyBegin, entry.keyEnd, entry.val);
+            }
+            batched.assign_batch(batch);
+            flat_batched.assign_batch(batch);
+
+            // Canonical form is unique, so equal maps have equal boundaries
+            assert(batched.size() == sequential.size());
+            assert(flat_batched.size() == sequential.size());
+            verify_canonical(batched);
+            for (int key = -2100; key < 2400; ++key) {
+                assert(batched[key] == sequential[key]);
+                assert(flat_batched[key] == sequential[key]);
+            }
+        }
+
+        // Keys too large to sort by value are sorted through pointers
+        interval_map<std::string, char> string_sequential('A');
+        interval_map<std::string, char> string_batched('A');
+        std::vector<interval_assignment<std::string, char>> string_batch;
+        for (int i = 0; i < 300; ++i) {
+            int start = random_key(100, 900);
+            std::string begin = std::to_string(start);
+            std::string end = std::to_string(start + random_key(-5, 80));
+            char val = static_cast<char>('A' + random_key(0, 3));
+            string_sequential.assign(begin, end, val);
+            string_batch.push_back({begin, end, val});
+        }
+        string_batched.assign_batch(string_batch);
+        assert(string_batched.size() == string_sequential.size());
+        for (int key = 90; key < 1000; ++key) {
+            assert(string_batched[std::to_string(key)] == string_sequential[std::to_string(key)]);
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_buffered_writes() {
+    try {
+        interval_map<int, char> eager('A');
+        buffered_interval_map<int, char> buffered('A', 512);
+
+        for (int burst = 0; burst < 200; ++burst) {
+            int burst_size = random_key(1, 300);
+            for (int i = 0; i < burst_size; ++i) {
+                int start = random_key(-1000, 1000);
+                int end = start + random_key(-5, 100);
+                char val = static_cast<char>('A' + random_key(0, 3));
+                eager.assign(start, end, val);
+                buffered.assign(start, end, val);
+            }
+            assert(buffered.pending() <= 512);
+
+            // Any read sees the eager result
+            int key = random_key(-1100, 1100);
+            assert(buffered[key] == eager[key]);
+            assert(buffered.pending() == 0);
+        }
+        verify_canonical(buffered.map());
+        for (int key = -1200; key < 1200; ++key) {
+            assert(buffered[key] == eager[key]);
+        }
+
+        // Reads through iteration flush as well
+        buffered.assign(5, 15, 'Z');
+        buffered.assign(10, 20, 'Y');
+        buffered.assign(10, 20, 'X');
+        assert(buffered.pending() == 2);
+        std::vector<std::tuple<int, int, char>> seen;
+        const int from = 5, to = 20;
+        for (const auto& [keyBegin, keyEnd, val] : buffered.intervals(from, to)) {
+            seen.emplace_back(keyBegin, keyEnd, val);
+        }
+        assert((seen == std::vector<std::tuple<int, int, char>>{{5, 10, 'Z'}, {10, 20, 'X'}}));
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_from_sorted() {
+    try {
+        // Redundant boundaries are dropped against the begin value and neighbours
+        std::vector<std::pair<int, char>> boundaries = {{-5, 'A'}, {0, 'B'}, {3, 'B'}, {7, 'C'}, {9, 'A'}, {12, 'A'}};
+        auto imap = interval_map<int, char>::from_sorted('A', boundaries.begin(), boundaries.end());
+        assert(imap.size() == 3);
+        verify_canonical(imap);
+        assert(imap[-1] == 'A');
+        assert(imap[0] == 'B');
+        assert(imap[5] == 'B');
+        assert(imap[7] == 'C');
+        assert(imap[9] == 'A');
+
+        // Rebuilding from an existing map's boundaries reproduces it
+        interval_map<int, char> source('A');
+        for (int i = 0; i < 1000; ++i) {
+            int start = random_key(-1000, 1000);
+            source.assign(start, start + random_key(1, 50), static_cast<char>('A' + (i % 6)));
+        }
+        const auto& storage = source.get_storage();
+        auto rebuilt = interval_map<int, char, flat_storage<int, char>>::from_sorted('A', storage.begin(), storage.end());
+        assert(rebuilt.size() == source.size());
+        for (int key = -1100; key < 1100; ++key) {
+            assert(rebuilt[key] == source[key]);
+        }
+
+        // Out-of-order and duplicate keys are rejected
+        for (auto bad : {std::vector<std::pair<int, char>>{{1, 'B'}, {0, 'C'}},
+                         std::vector<std::pair<int, char>>{{1, 'B'}, {1, 'C'}}}) {
+            bool thrown = false;
+            try {
+                interval_map<int, char>::from_sorted('A', bad.begin(), bad.end());
+            } catch (const std::invalid_argument&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_combine() {
+    try {
+        interval_map<int, char> base('A');
+        interval_map<int, int, flat_storage<int, int>> overrides(0);
+        for (int i = 0; i < 3000; ++i) {
+            int start = random_key(-20000, 20000);
+            base.assign(start, start + random_key(1, 40), static_cast<char>('A' + random_key(0, 3)));
+            start = random_key(-20000, 20000);
+            overrides.assign(start, start + random_key(1, 40), random_key(0, 2));
+        }
+
+        // Override 0 keeps the base value, anything else replaces it
+        auto overlay = [](char policy, int level) { return level == 0 ? policy : static_cast<char>('X' + level); };
+        auto combined = combine(base, overrides, overlay);
+        verify_canonical(combined);
+        assert(combined.get_begin_value() == 'A');
+        for (int key = -20100; key < 20100; ++key) {
+            assert(combined[key] == overlay(base[key], overrides[key]));
+        }
+
+        // A reducer that discards one side collapses to the other's boundaries
+        auto left = combine(base, overrides, [](char policy, int) { return policy; });
+        assert(left.size() == base.size());
+
+        // Splitting the key range gives the same canonical map
+        interval_map<int, int> wide_a(0);
+        interval_map<int, int> wide_b(0);
+        for (int i = 0; i < 200000; ++i) {
+            wide_a.assign(2 * i, 2 * i + 1, i % 3 + 1);
+            wide_b.assign(3 * i, 3 * i + 2, i % 5 + 1);
+        }
+        auto maximum = [](int x, int y) { return std::max(x, y); };
+        auto sequential = combine(wide_a, wide_b, maximum);
+        auto parallel = combine(wide_a, wide_b, maximum, 4);
+        assert(sequential.size() == parallel.size());
+        assert(std::equal(sequential.get_storage().begin(), sequential.get_storage().end(),
+                          parallel.get_storage().begin()));
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_snapshot_files() {
+    const std::string path = (std::filesystem::temp_directory_path() / "interval_map_test.snap").string();
+    try {
+        interval_map<int, char> imap('A');
+        for (int i = 0; i < 5000; ++i) {
+            int start = random_key(-10000, 10000);
+            imap.assign(start, start + random_key(1, 50), static_cast<char>('A' + random_key(0, 4)));
+        }
+        save_snapshot(imap, path);
+
+        {
+            auto mapped = mapped_interval_map<int, char>::open(path);
+            assert(mapped.size() == imap.size());
+            assert(mapped.get_begin_value() == 'A');
+            assert(mapped.verify());
+            for (int key = -10100; key < 10100; ++key) {
+                assert(mapped[key] == imap[key]);
+            }
+
+            // Saving again replaces the file; the old mapping keeps its pages
+            save_snapshot(interval_map<int, char>('Z'), path);
+            assert(mapped[std::numeric_limits<int>::min()] == 'A');
+            auto empty = mapped_interval_map<int, char>::open(path);
+            assert(empty.size() == 0);
+            assert(empty[0] == 'Z');
+        }
+
+        // Other flat backends write the same format
+        interval_map<long long, double, flat_storage<long long, double>> flat(0.5);
+        flat.assign(-3, 7, 1.5);
+        save_snapshot(flat, path);
+        auto wide = mapped_interval_map<long long, double>::open(path);
+        assert(wide[-4] == 0.5 && wide[-3] == 1.5 && wide[7] == 0.5);
+
+        // A mismatched type is rejected up front, corruption by verify()
+        bool thrown = false;
+        try {
+            mapped_interval_map<int, char>::open(path);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        save_snapshot(imap, path);
+        {
+            std::FILE* file = std::fopen(path.c_str(), "r+b");
+            std::fseek(file, -1, SEEK_END);
+            std::fputc(0x5a, file);
+            std::fclose(file);
+        }
+        auto corrupted = mapped_interval_map<int, char>::open(path);
+        assert(!corrupted.verify());
+
+        std::filesystem::remove(path);
+        return true;
+    } catch (...) {
+        std::filesystem::remove(path);
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_delimited_io() {
+    const std::string path = (std::filesystem::temp_directory_path() / "interval_map_test.csv").string();
+    try {
+        // Tiny buffers so lines straddle chunks and outgrow the buffer
+        std::vector<std::tuple<long long, long long, int>> rows;
+        {
+            line_writer out(path, 256);
+            for (int i = 0; i < 2000; ++i) {
+                rows.emplace_back(random_key(-1000000, 1000000), random_key(-1000000, 1000000), random_key(-9, 9));
+                const auto& [a, b, c] = rows.back();
+                out.write_fields(',', a, b, c);
+            }
+            out.flush();
+            assert(out.bytes_written() == std::filesystem::file_size(path));
+        }
+        for (bool map : {false, true}) {
+            line_reader reader(path, map, 64);
+            std::string_view line;
+            long long a, b;
+            int c;
+            for (const auto& row : rows) {
+                assert(reader.next(line));
+                assert(parse_fields(line, ',', a, b, c));
+                assert(std::make_tuple(a, b, c) == row);
+            }
+            assert(!reader.next(line));
+            assert(reader.line_number() == rows.size());
+            assert(reader.bytes_consumed() == reader.size());
+        }
+
+        // CRLF endings, a missing final newline, a line longer than the
+        // chunk and malformed fields
+        {
+            std::FILE* file = std::fopen(path.c_str(), "wb");
+            std::string long_line(300, '7');
+            std::fputs((" 1 , -2,3\r\n\n" + long_line + "\nx,1\n4,5,\n6,7").c_str(), file);
+            std::fclose(file);
+        }
+        line_reader reader(path, false, 64);
+        std::string_view line;
+        long long a, b, c;
+        assert(reader.next(line) && parse_fields(line, ',', a, b, c) && a == 1 && b == -2 && c == 3);
+        assert(reader.next(line) && line.empty());
+        assert(reader.next(line) && line.size() == 300 && !parse_fields(line, ',', a));
+        assert(reader.next(line) && !parse_fields(line, ',', a, b));
+        assert(reader.next(line) && !parse_fields(line, ',', a, b, c) && !parse_fields(line, ',', a, b));
+        assert(reader.next(line) && parse_fields(line, ',', a, b) && a == 6 && b == 7);
+        assert(!reader.next(line) && reader.line_number() == 6);
+
+        bool thrown = false;
+        try {
+            line_reader missing(path + ".missing");
+        } catch (const std::system_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        std::filesystem::remove(path);
+        return true;
+    } catch (...) {
+        std::filesystem::remove(path);
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_write_ahead_log() {
+    namespace fs = std::filesystem;
+    const fs::path directory = fs::temp_directory_path() / "interval_map_test_wal";
+    fs::remove_all(directory);
+    try {
+        interval_map<int, char> reference('A');
+        auto assign_random = [&reference](interval_map_wal<int, char>& wal, int count) {
+            for (int i = 0; i < count; ++i) {
+                int start = random_key(-5000, 5000);
+                int end = start + random_key(0, 80);
+                char val = static_cast<char>('A' + random_key(0, 3));
+                wal.assign(start, end, val);
+                reference.assign(start, end, val);
+            }
+        };
+        auto matches_reference = [&reference](const interval_map_wal<int, char>& wal) {
+            if (wal.map().size() != reference.size()) return false;
+            for (int key = -5100; key < 5200; ++key) {
+                if (wal[key] != reference[key]) return false;
+            }
+            return true;
+        };
+        auto count_files = [&directory](const std::string& extension) {
+            int count = 0;
+            for (const auto& entry : fs::directory_iterator(directory)) {
+                count += entry.path().extension() == extension;
+            }
+            return count;
+        };
+
+        // Replay alone restores the map; every reopen starts a new log
+        {
+            interval_map_wal<int, char> wal(directory.string(), 'A', {16, 100});
+            assign_random(wal, 1000);
+        }
+        {
+            interval_map_wal<int, char> wal(directory.string(), 'A', {16, 100});
+            assert(wal.replayed() > 0);
+            assert(matches_reference(wal));
+            assign_random(wal, 500);
+            wal.sync();
+        }
+        assert(count_files(".wal") == 2);
+
+        // Compaction folds the logs into a snapshot and deletes them
+        {
+            interval_map_wal<int, char> wal(directory.string(), 'A');
+            assert(matches_reference(wal));
+            wal.compact_async();
+            assign_random(wal, 500);
+            wal.wait_compaction();
+            assert(count_files(".snap") == 1);
+            assert(count_files(".wal") == 1);
+        }
+        {
+            interval_map_wal<int, char> wal(directory.string(), 'Z');
+            assert(wal.map().get_begin_value() == 'A');
+            assert(matches_reference(wal));
+            assign_random(wal, 200);
+        }
+
+        // A torn record at the end of a log is dropped along with everything after it
+        fs::path newest;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.path().extension() == ".wal" && entry.path() > newest) newest = entry.path();
+        }
+        fs::resize_file(newest, fs::file_size(newest) - 3);
+        {
+            interval_map_wal<int, char> wal(directory.string(), 'A');
+            int keys_differing = 0;
+            for (int key = -5100; key < 5200; ++key) {
+                keys_differing += wal[key] != reference[key];
+            }
+            assert(keys_differing <= 80);
+        }
+
+        fs::remove_all(directory);
+        return true;
+    } catch (...) {
+        fs::remove_all(directory);
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_persistent_versions() {
+    try {
+        persistent_interval_map<int, char> versioned('A');
+        interval_map<int, char> reference('A');
+        assert(versioned.version() == 0 && versioned.size() == 0);
+
+        // Keep a full copy of every 50th version to check history against
+        std::vector<std::pair<persistent_interval_map<int, char>::version_type, interval_map<int, char>>> checkpoints;
+        std::vector<persistent_interval_map<int, char>::version_view> views;
+        for (int i = 1; i <= 3000; ++i) {
+            int start = random_key(-500, 500);
+            int end = start + random_key(-5, i % 10 == 0 ? 400 : 30);
+            char val = static_cast<char>('A' + random_key(0, 4));
+            assert(versioned.assign(start, end, val) == static_cast<unsigned>(i));
+            reference.assign(start, end, val);
+            assert(versioned.size() == reference.size());
+            if (i % 50 == 0) {
+                checkpoints.emplace_back(versioned.version(), reference);
+                views.push_back(versioned.snapshot());
+            }
+        }
+
+        // Boundaries come out in the same canonical form interval_map keeps
+        std::vector<std::pair<int, char>> boundaries;
+        versioned.snapshot().for_each_boundary([&](int key, char val) { boundaries.emplace_back(key, val); });
+        assert(std::equal(boundaries.begin(), boundaries.end(), reference.get_storage().begin(), reference.get_storage().end(),
+                          [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; }));
+
+        // Every retained version answers as the map did back then
+        for (size_t c = 0; c < checkpoints.size(); ++c) {
+            const auto& [version, then] = checkpoints[c];
+            assert(views[c].version() == version && views[c].size() == then.size());
+            for (int key = -520; key < 950; key += 7) {
+                assert(versioned.lookup_at(version, key) == then[key]);
+                assert(views[c][key] == then[key]);
+            }
+        }
+
+        // The values on either side of an assignment are read from the path
+        // copies the split makes, which must survive rebuilding the root
+        persistent_interval_map<int, char> split('A');
+        split.assign(3, 13, 'B');
+        split.assign(18, 26, 'C');
+        split.assign(12, 15, 'D');
+        assert(split[2] == 'A' && split[3] == 'B' && split[12] == 'D' && split[15] == 'A');
+        assert(split[18] == 'C' && split[26] == 'A' && split.size() == 5 && split.lookup_at(2, 12) == 'B');
+
+        // An empty interval still advances the version without changing it
+        auto before = versioned.version();
+        versioned.assign(10, 10, 'Z');
+        assert(versioned.version() == before + 1 && versioned.at(before + 1).size() == versioned.at(before).size());
+
+        // Released versions are gone from the map but views keep theirs
+        versioned.release_before(checkpoints.back().first);
+        assert(versioned.oldest_version() == checkpoints.back().first);
+        bool threw = false;
+        try {
+            versioned.lookup_at(checkpoints.front().first, 0);
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+        for (int key = -520; key < 950; key += 11) {
+            assert(views.front()[key] == checkpoints.front().second[key]);
+        }
+
+        // A view outlives the map and reads from another thread
+        auto last = versioned.snapshot();
+        {
+            persistent_interval_map<int, char> scratch('A');
+            scratch.assign(0, 100, 'B');
+            last = scratch.snapshot();
+        }
+        char seen = 0;
+        std::thread reader([&] { seen = last[50]; });
+        reader.join();
+        assert(seen == 'B' && last[100] == 'A' && last.get_begin_value() == 'A');
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_concurrent_readers() {
+    try {
+        concurrent_interval_map<int, char> cmap('A', 8, 4);
+        const int NUM_PUBLISHES = 2000;
+        std::atomic<bool> done{false};
+        std::atomic<bool> consistent{true};
+
+        // Every version paints [0, 100) with a single value, so a reader that
+        // ever sees two values inside one version observed a torn update
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 3; ++t) {
+            readers.emplace_back([&cmap, &done, &consistent] {
+                auto reader = cmap.make_reader();
+                while (!done.load()) {
+                    bool same = reader.read([](const interval_map<int, char>& map) {
+                        return map[0] == map[50] && map[50] == map[99];
+                    });
+                    if (!same) consistent.store(false);
+                }
+            });
+        }
+
+        for (int i = 0; i < NUM_PUBLISHES; ++i) {
+            char val = static_cast<char>('B' + (i % 20));
+            cmap.assign(0, 50, val);
+            cmap.assign(50, 100, val);
+            cmap.publish();
+        }
+        done.store(true);
+        for (auto& thread : readers) {
+            thread.join();
+        }
+        assert(consistent.load());
+
+        // Queued assignments become visible on publish or a full batch
+        auto reader = cmap.make_reader();
+        char last = static_cast<char>('B' + ((NUM_PUBLISHES - 1) % 20));
+        cmap.assign(200, 300, 'Z');
+        assert(reader[250] == 'A');
+        cmap.publish();
+        assert(reader[250] == 'Z');
+        assert(reader[99] == last);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_sharded_map() {
+    try {
+        interval_map<int, char> reference('A');
+        sharded_interval_map<int, char> sharded('A', {-500, -100, 0, 1, 250, 700});
+        assert(sharded.shard_count() == 7);
+
+        // Wide intervals cross several seams, short ones land on them
+        for (int i = 0; i < 3000; ++i) {
+            int start = random_key(-1000, 1000);
+            int end = start + ((i % 3 == 0) ? random_key(0, 1500) : random_key(0, 5));
+            char val = static_cast<char>('A' + random_key(0, 3));
+            reference.assign(start, end, val);
+            sharded.assign(start, end, val);
+        }
+
+        for (int key = -1100; key < 2600; ++key) {
+            assert(sharded[key] == reference[key]);
+        }
+
+        // Canonical form holds across seams: the boundaries match exactly
+        auto boundaries = sharded.boundaries();
+        assert(boundaries.size() == reference.size());
+        size_t i = 0;
+        for (const auto& [key, val] : reference.get_storage()) {
+            assert(boundaries[i].first == key);
+            assert(boundaries[i].second == val);
+            ++i;
+        }
+
+        // Writers on disjoint ranges run concurrently
+        sharded_interval_map<int, char> parallel('A', {1000, 2000, 3000});
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&parallel, t] {
+                for (int k = 0; k < 1000; k += 2) {
+                    parallel.assign(t * 1000 + k, t * 1000 + k + 1, static_cast<char>('B' + t));
+                }
+            });
+        }
+        for (auto& thread : writers) {
+            thread.join();
+        }
+        assert(parallel.boundaries().size() == 4000);
+        assert(parallel[2500] == 'D');
+        assert(parallel[2501] == 'A');
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_parallel_bulk() {
+    try {
+        thread_pool pool(4);
+        assert(pool.size() == 4);
+
+        // Every index is visited exactly once, by whichever thread got it
+        std::vector<std::atomic<int>> visits(100000);
+        pool.parallel_for(visits.size(), 1000, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) visits[i].fetch_add(1);
+        });
+        assert(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v.load() == 1; }));
+
+        // A throwing chunk surfaces in the caller once the rest are done
+        std::atomic<int> finished{0};
+        bool threw = false;
+        try {
+            pool.parallel_for(64, 1, [&](size_t begin, size_t) {
+                if (begin == 17) throw std::runtime_error("chunk failed");
+                finished.fetch_add(1);
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && finished.load() == 63);
+
+        interval_map<int, char> imap('A');
+        for (int i = 0; i < 20000; ++i) {
+            int start = random_key(-1000000, 1000000);
+            imap.assign(start, start + random_key(1, 200), static_cast<char>('B' + i % 7));
+        }
+        std::vector<int> keys(300001);
+        for (int& key : keys) {
+            key = random_key(-1100000, 1100000);
+        }
+        std::vector<char> out(keys.size()), frozen_out(keys.size());
+        parallel_lookup(imap, keys.data(), keys.size(), out.data(), pool);
+        parallel_lookup(imap.freeze(), keys.data(), keys.size(), frozen_out.data(), pool);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            assert(out[i] == imap[keys[i]] && frozen_out[i] == out[i]);
+        }
+
+        // A pool of one runs everything on the caller
+        thread_pool inline_pool(1);
+        std::vector<char> inline_out(keys.size());
+        parallel_lookup(imap, keys.data(), keys.size(), inline_out.data(), inline_pool);
+        assert(inline_out == out);
+
+        // Runs of repeated values straddle the chunk edges
+        std::vector<std::pair<int, char>> boundaries;
+        for (int key = 0; key < 500000; ++key) {
+            boundaries.emplace_back(key * 2, static_cast<char>('A' + (key / 3) % 4));
+        }
+        auto sequential = interval_map<int, char>::from_sorted('A', boundaries.begin(), boundaries.end());
+        auto parallel = parallel_from_sorted<int, char>('A', boundaries.begin(), boundaries.end(), pool);
+        assert(parallel.size() == sequential.size());
+        assert(std::equal(sequential.get_storage().begin(), sequential.get_storage().end(), parallel.get_storage().begin(),
+                          [](const auto& a, const auto& b) { return a.first == b.first && a.second == b.second; }));
+        verify_canonical(parallel);
+
+        std::swap(boundaries[400000], boundaries[400001]);
+        threw = false;
+        try {
+            parallel_from_sorted<int, char>('A', boundaries.begin(), boundaries.end(), pool);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_interval_iteration() {
+    try {
+        interval_map<int, char> imap('A');
+        imap.assign(0, 10, 'B');
+        imap.assign(10, 20, 'C');
+        imap.assign(30, 40, 'B');
+
+        // Clipped at both ends, including the unbounded outer intervals
+        std::vector<std::tuple<int, int, char>> seen;
+        const int from = -5, to = 35;
+        for (auto interval : imap.intervals(from, to)) {
+            seen.emplace_back(interval.keyBegin, interval.keyEnd, interval.val);
+        }
+        std::vector<std::tuple<int, int, char>> expected = {
+            {-5, 0, 'A'}, {0, 10, 'B'}, {10, 20, 'C'}, {20, 30, 'A'}, {30, 35, 'B'}};
+        assert(seen == expected);
+
+        // Temporary bounds are copied, so the range and its iterators do not
+        // refer to them
+        interval_map<std::string, int> names(0);
+        names.assign("b", "f", 1);
+        names.assign("h", "p", 2);
+        std::vector<std::tuple<std::string, std::string, int>> named;
+        for (auto interval : names.intervals(std::string("d"), std::string("k"))) {
+            named.emplace_back(interval.keyBegin, interval.keyEnd, interval.val);
+        }
+        std::vector<std::tuple<std::string, std::string, int>> named_expected = {
+            {"d", "f", 1}, {"f", "h", 0}, {"h", "k", 2}};
+        assert(named == named_expected);
+        auto first = imap.intervals(from + 1, to - 1).begin();
+        assert((*first).keyBegin == -4 && (*first).keyEnd == 0 && (*++first).keyEnd == 10);
+        int count = 0;
+        imap.for_each_interval(12, 15, [&count](int begin, int end, char val) {
+            assert(begin == 12 && end == 15 && val == 'C');
+            ++count;
+        });
+        assert(count == 1);
+        assert(imap.intervals(5, 5).begin() == imap.intervals(5, 5).end());
+        verify_interval(imap, 30, 40, 'B');
+
+        // Random maps: the reported intervals tile the query and match lookups
+        for (int round = 0; round < 200; ++round) {
+            int start = random_key(-300, 300);
+            imap.assign(start, start + random_key(1, 40), static_cast<char>('A' + random_key(0, 4)));
+            int query_begin = random_key(-350, 350);
+            int query_end = query_begin + random_key(0, 200);
+            int cursor = query_begin;
+            char prev_val = 0;
+            imap.for_each_interval(query_begin, query_end, [&](int begin, int end, char val) {
+                assert(begin == cursor && begin < end && val != prev_val);
+                verify_interval(imap, begin, end, val);
+                cursor = end;
+                prev_val = val;
+            });
+            assert(cursor == std::max(query_begin, query_end));
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool IntervalMapTester::test_stats() {
+    try {
+        interval_map<int, char> imap('A');
+        imap.assign(0, 10, 'B');     // two boundaries
+        imap.assign(10, 20, 'B');    // joins [0, 10) and the old boundary at 10 goes
+        imap.assign(5, 5, 'C');      // empty, still an assign call
+        for (int key = 0; key < 100; ++key) {
+            (void)imap[key];
+        }
+        std::vector<interval_assignment<int, char>> batch = {{30, 40, 'C'}, {35, 45, 'D'}};
+        imap.assign_batch(batch);
+
+        interval_map_stats stats = imap.stats();
+        if constexpr (interval_map_stats::enabled) {
+            assert(stats.assigns == 5);
+            assert(stats.lookups == 100);
+            assert(stats.boundaries_inserted >= 3);
+            assert(stats.boundaries_erased >= 1);
+            assert(stats.merges >= 1);
+            assert(stats.size_high_water >= imap.size());
+            assert(stats.lookup_latency.samples() == 100 / interval_map_stats::sample_period);
+            assert(stats.lookup_latency.percentile_ns(0.5) > 0);
+
+            // Copies carry the counters over; reset clears them
+            interval_map<int, char> copy(imap);
+            assert(copy.stats().lookups == 100);
+            imap.reset_stats();
+            assert(imap.stats().assigns == 0 && imap.stats().lookup_latency.samples() == 0);
+        } else {
+            // Without instrumentation nothing is counted and nothing is stored
+            assert(stats.assigns == 0 && stats.lookups == 0 && stats.size_high_water == 0);
+            struct layout {
+                char valBegin;
+                std::uint64_t epoch;
+                std::uint64_t id;
+                interval_map<int, char>::storage_type storage;
+            };
+            assert(sizeof(interval_map<int, char>) == sizeof(layout));
+            struct unpadded_layout {
+                long valBegin;
+                std::uint64_t epoch;
+                std::uint64_t id;
+                map_storage<int, long> storage;
+            };
+            assert((sizeof(interval_map<int, long, map_storage<int, long>>) == sizeof(unpadded_layout)));
+        }
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 bool IntervalMapTester::test_random_intervals() {
     try {
         interval_map<int, char> imap('A');
@@ -337,16 +1781,16 @@ bool IntervalMapTester::test_random_intervals() {
         }
         
         // Verify internal consistency
-        auto& map = imap.get_map();
-        if (!map.empty()) {
-            auto it = map.begin();
-            char prev_val = it->second;
+        auto& storage = imap.get_storage();
+        if (!storage.empty()) {
+            auto it = storage.begin();
+            char prev_val = storage.value(it);
             ++it;
             
             // Verify canonicalization - no adjacent intervals with same value
-            while (it != map.end()) {
-                assert(it->second != prev_val);
-                prev_val = it->second;
+            while (it != storage.end()) {
+                assert(storage.value(it) != prev_val);
+                prev_val = storage.value(it);
                 ++it;
             }
         }
@@ -373,7 +1817,18 @@ void IntervalMapTester::verify_interval(const interval_map<int, char>& imap, int
     }
 }
 
-size_t IntervalMapTester::get_memory_usage(const interval_map<int, char>& imap) {
-    // Returns the number of nodes in the internal map
-    return imap.get_map().size();
+template<typename Storage>
+void IntervalMapTester::verify_canonical(const interval_map<int, char, Storage>& imap) {
+    // No boundary may repeat the value already in effect to its left
+    char prev_val = imap.get_begin_value();
+    for (const auto& [key, val] : imap.get_storage()) {
+        assert(val != prev_val);
+        prev_val = val;
+    }
+}
+
+template<typename Storage>
+size_t IntervalMapTester::get_memory_usage(const interval_map<int, char, Storage>& imap) {
+    // Bytes of the map object plus the boundary storage it owns
+    return sizeof(imap) + imap.get_storage().memory_usage();
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "interval_map_workload.h"
+#include "interval_map.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <sstream>
+#include <type_traits>
+
+#include <sys/resource.h>
+
+namespace {
+
+const int KEY_SPACE = 1 << 24;
+
+// The default backend of interval_map<int, char>, drawing from a counting
+// resource so peak bytes are measured rather than estimated
+using workload_storage = packed_storage<int, char, std::pmr::polymorphic_allocator<std::pair<const int, char>>>;
+static_assert(std::is_same_v<interval_map<int, char>::storage_type, packed_storage<int, char>>,
+              "workloads should time the default storage");
+const char* const WORKLOAD_STORAGE = "packed_storage";
+
+// Forwards to new/delete and tracks the bytes outstanding and their peak
+class peak_resource : public std::pmr::memory_resource {
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        current += bytes;
+        peak = std::max(peak, current);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        current -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    size_t current = 0;
+    size_t peak = 0;
+};
+
+// Fraction of operations that are lookups, per workload
+double read_fraction(const std::string& name) {
+    if (name == "read_heavy") return 0.95;
+    if (name == "write_heavy") return 0.05;
+    if (name == "sequential_append") return 0.1;
+    return 0.5;
+}
+
+} // namespace
+
+const std::vector<std::string>& IntervalMapWorkloads::workload_names() {
+    static const std::vector<std::string> names = {
+        "uniform", "clustered", "sequential_append", "read_heavy", "write_heavy", "wide_overwrite", "tiny_intervals"
+    };
+    return names;
+}
+
+std::vector<IntervalMapWorkloads::operation>
+IntervalMapWorkloads::generate(const std::string& name, size_t prefill, size_t operations, std::mt19937_64& gen) {
+    std::uniform_int_distribution<int> uniform_key(0, KEY_SPACE - 1);
+    std::uniform_int_distribution<int> short_length(1, 256);
+    std::uniform_int_distribution<int> wide_length(KEY_SPACE / 100, KEY_SPACE / 10);
+    std::uniform_int_distribution<int> value(0, 3);
+    std::bernoulli_distribution is_read(read_fraction(name));
+
+    // Clustered keys fall around a few hot spots
+    std::vector<int> centers(16);
+    for (int& center : centers) {
+        center = uniform_key(gen);
+    }
+    std::uniform_int_distribution<size_t> pick_center(0, centers.size() - 1);
+    std::normal_distribution<double> spread(0.0, 4096.0);
+    auto clustered_key = [&] {
+        double key = centers[pick_center(gen)] + spread(gen);
+        return static_cast<int>(std::clamp(key, 0.0, static_cast<double>(KEY_SPACE - 1)));
+    };
+
+    std::vector<operation> ops;
+    ops.reserve(prefill + operations);
+    int append_at = 0;
+    for (size_t i = 0; i < prefill + operations; ++i) {
+        bool read = i >= prefill && is_read(gen);
+        operation op{!read, 0, 0, static_cast<char>('B' + value(gen))};
+        if (name == "clustered") {
+            op.keyBegin = clustered_key();
+            op.keyEnd = op.keyBegin + short_length(gen);
+        } else if (name == "sequential_append") {
+            // Reads look anywhere in the written prefix
+            op.keyBegin = read ? std::uniform_int_distribution<int>(0, std::max(append_at, 1))(gen) : append_at;
+            op.keyEnd = op.keyBegin + 2;
+            if (!read) append_at += 4;
+        } else if (name == "wide_overwrite") {
+            op.keyBegin = uniform_key(gen);
+            op.keyEnd = op.keyBegin + wide_length(gen);
+        } else if (name == "tiny_intervals") {
+            op.keyBegin = uniform_key(gen);
+            op.keyEnd = op.keyBegin + 1;
+        } else {
+            op.keyBegin = uniform_key(gen);
+            op.keyEnd = op.keyBegin + short_length(gen);
+        }
+        ops.push_back(op);
+    }
+    return ops;
+}
+
+IntervalMapWorkloads::latency_summary IntervalMapWorkloads::summarize(std::vector<double>& latencies) {
+    latency_summary summary;
+    summary.count = latencies.size();
+    if (latencies.empty()) return summary;
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        size_t index = static_cast<size_t>(p * static_cast<double>(latencies.size() - 1) + 0.5);
+        return latencies[index];
+    };
+    double total = 0;
+    for (double latency : latencies) {
+        total += latency;
+    }
+    summary.mean = total / static_cast<double>(latencies.size());
+    summary.p50 = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    summary.p999 = percentile(0.999);
+    summary.max = latencies.back();
+    return summary;
+}
+
+IntervalMapWorkloads::workload_result IntervalMapWorkloads::run_workload(const std::string& name,
+                                                                         const workload_options& options) {
+    // Every workload starts from the same seed, so each is reproducible alone
+    std::mt19937_64 gen(options.seed);
+    const size_t prefill = options.operations / 10;
+    std::vector<operation> ops = generate(name, prefill, options.operations, gen);
+
+    peak_resource memory;
+    interval_map<int, char, workload_storage> imap('A', &memory);
+    for (size_t i = 0; i < prefill; ++i) {
+        imap.assign(ops[i].keyBegin, ops[i].keyEnd, ops[i].val);
+    }
+
+    std::vector<double> assign_ns;
+    std::vector<double> lookup_ns;
+    assign_ns.reserve(options.operations);
+    lookup_ns.reserve(options.operations);
+    unsigned checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = prefill; i < ops.size(); ++i) {
+        const operation& op = ops[i];
+        auto start = std::chrono::steady_clock::now();
+        if (op.assign) {
+            imap.assign(op.keyBegin, op.keyEnd, op.val);
+        } else {
+            checksum += static_cast<unsigned char>(imap[op.keyBegin]);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        (op.assign ? assign_ns : lookup_ns).push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Keep the lookups observable so they are not optimized away
+    volatile unsigned sink = checksum;
+    (void)sink;
+
+    workload_result result;
+    result.name = name;
+    result.operations = options.operations;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    result.boundaries = imap.size();
+    result.peak_bytes = memory.peak;
+    result.assign = summarize(assign_ns);
+    result.lookup = summarize(lookup_ns);
+    return result;
+}
+
+void IntervalMapWorkloads::print_table(std::ostream& out, const std::vector<workload_result>& results) {
+    out << std::left << std::setw(20) << "workload" << std::right
+              << std::setw(10) << "Mops/s" << std::setw(12) << "boundaries" << std::setw(12) << "peak KiB"
+              << std::setw(26) << "assign p50/p99/max ns" << std::setw(26) << "lookup p50/p99/max ns" << std::endl;
+    auto latencies = [](const latency_summary& summary) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(0) << summary.p50 << "/" << summary.p99 << "/" << summary.max;
+        return text.str();
+    };
+    for (const workload_result& result : results) {
+        out << std::left << std::setw(20) << result.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << result.operations / result.seconds / 1e6
+                  << std::setw(12) << result.boundaries
+                  << std::setw(12) << result.peak_bytes / 1024
+                  << std::setw(26) << latencies(result.assign)
+                  << std::setw(26) << latencies(result.lookup) << std::endl;
+    }
+}
+
+void IntervalMapWorkloads::write_json(std::ostream& out, const workload_options& options,
+                                      const std::vector<workload_result>& results) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    auto summary = [&out](const char* key, const latency_summary& s) {
+        out << "      \"" << key << "\": {\"count\": " << s.count << ", \"mean_ns\": " << s.mean
+            << ", \"p50_ns\": " << s.p50 << ", \"p90_ns\": " << s.p90 << ", \"p99_ns\": " << s.p99
+            << ", \"p999_ns\": " << s.p999 << ", \"max_ns\": " << s.max << "}";
+    };
+    out << std::fixed << std::setprecision(1);
+    out << "{\n  \"format\": 1,\n  \"storage\": \"" << WORKLOAD_STORAGE << "\",\n  \"seed\": " << options.seed << ",\n  \"operations\": " << options.operations
+        << ",\n  \"max_rss_kib\": " << usage.ru_maxrss << ",\n  \"workloads\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const workload_result& result = results[i];
+        out << "    {\n      \"name\": \"" << result.name << "\",\n"
+            << "      \"throughput_ops_per_s\": " << result.operations / result.seconds << ",\n"
+            << "      \"boundaries\": " << result.boundaries << ",\n"
+            << "      \"peak_bytes\": " << result.peak_bytes << ",\n";
+        summary("assign", result.assign);
+        out << ",\n";
+        summary("lookup", result.lookup);
+        out << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+bool IntervalMapWorkloads::run(const workload_options& options) {
+    std::vector<std::string> selected = options.workloads.empty() ? workload_names() : options.workloads;
+    for (const std::string& name : selected) {
+        if (std::find(workload_names().begin(), workload_names().end(), name) == workload_names().end()) {
+            std::cerr << "unknown workload: " << name << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<workload_result> results;
+    for (const std::string& name : selected) {
+        results.push_back(run_workload(name, options));
+    }
+    // With JSON on stdout the table moves to stderr
+    print_table(options.json_path == "-" ? std::cerr : std::cout, results);
+
+    if (options.json_path == "-") {
+        write_json(std::cout, options, results);
+    } else if (!options.json_path.empty()) {
+        std::ofstream file(options.json_path);
+        write_json(file, options, results);
+        if (!file) {
+            std::cerr << "cannot write " << options.json_path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,252 @@
+#include "interval_map.h"
+#include "interval_map_io.h"
+#include "mapped_interval_map.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using key_type = std::int64_t;
+using value_type = std::int64_t;
+using tool_map = interval_map<key_type, value_type>;
+
+struct tool_options {
+    std::vector<std::string> assign_paths;
+    std::vector<std::string> query_paths;
+    std::string out_path = "-";
+    std::string export_path;
+    std::string save_path;
+    value_type default_value = 0;
+    char delimiter = ',';
+    bool map_input = false;
+    std::size_t batch = 1 << 20;
+    bool quiet = false;
+};
+
+void print_usage(const char* program) {
+    std::cerr << "usage: " << program << " [--assign FILE]... [--query FILE]... [--export PATH|-] [options]\n"
+              << "  --assign FILE     apply begin,end,value lines, files in order\n"
+              << "  --query FILE      answer key lines with key,value\n"
+              << "  --out PATH|-      where query answers go (default -)\n"
+              << "  --export PATH|-   write the canonical begin,end,value intervals\n"
+              << "  --save PATH       write a binary snapshot for mapped_interval_map\n"
+              << "  --default V       value outside every interval (default 0)\n"
+              << "  --delimiter C     field separator (default ,)\n"
+              << "  --mmap            map input files instead of reading them in chunks\n"
+              << "  --batch N         assignments per assign_batch call (default 1048576)\n"
+              << "  --quiet           no progress or timing on stderr\n"
+              << "Keys and values are 64-bit integers. Blank lines, lines starting with #\n"
+              << "and an unparsable first line after them (a header) are skipped." << std::endl;
+}
+
+// Reports one pass over a file on stderr: progress about once a second,
+// then totals and throughput
+class phase_report {
+private:
+    using clock = std::chrono::steady_clock;
+    std::string m_label;
+    bool m_quiet;
+    clock::time_point m_start = clock::now();
+    clock::time_point m_lastPrint = m_start;
+
+    static double megabytes(std::uint64_t bytes) { return bytes / 1e6; }
+
+public:
+    phase_report(std::string label, bool quiet) : m_label(std::move(label)), m_quiet(quiet) {}
+
+    void progress(std::uint64_t bytes, std::uint64_t total, std::uint64_t rows) {
+        if (m_quiet) return;
+        clock::time_point now = clock::now();
+        if (now - m_lastPrint < std::chrono::seconds(1)) return;
+        m_lastPrint = now;
+        double seconds = std::chrono::duration<double>(now - m_start).count();
+        std::cerr << m_label << ": " << std::fixed << std::setprecision(1) << megabytes(bytes);
+        if (total > 0) {
+            std::cerr << "/" << megabytes(total) << " MB (" << std::setprecision(0) << 100.0 * bytes / total << "%)";
+        } else {
+            std::cerr << " MB";
+        }
+        std::cerr << ", " << rows << " rows, " << std::setprecision(1) << megabytes(bytes) / seconds << " MB/s"
+                  << std::endl;
+    }
+
+    void finish(std::uint64_t bytes, std::uint64_t rows, std::string const& detail) {
+        if (m_quiet) return;
+        double seconds = std::chrono::duration<double>(clock::now() - m_start).count();
+        std::cerr << m_label << ": " << std::fixed << std::setprecision(1) << megabytes(bytes) << " MB, " << rows
+                  << " rows in " << std::setprecision(3) << seconds << " s (" << std::setprecision(1)
+                  << megabytes(bytes) / std::max(seconds, 1e-9) << " MB/s)";
+        if (!detail.empty()) std::cerr << ", " << detail;
+        std::cerr << std::endl;
+    }
+};
+
+bool skipped(std::string_view line) {
+    return line.empty() || line.front() == '#';
+}
+
+std::runtime_error input_error(line_reader const& reader, std::string const& expected) {
+    return std::runtime_error(reader.path() + ":" + std::to_string(reader.line_number()) + ": expected " + expected);
+}
+
+void apply_assignments(tool_map& imap, std::string const& path, tool_options const& options) {
+    line_reader reader(path, options.map_input);
+    phase_report report("assign " + path, options.quiet);
+
+    // One reused batch; lines are parsed straight into it
+    std::vector<interval_assignment<key_type, value_type>> batch;
+    batch.reserve(options.batch);
+    std::uint64_t rows = 0;
+    bool first = true;
+    std::string_view line;
+    while (reader.next(line)) {
+        if (skipped(line)) continue;
+        bool header = std::exchange(first, false);
+        interval_assignment<key_type, value_type> entry;
+        if (!parse_fields(line, options.delimiter, entry.keyBegin, entry.keyEnd, entry.val)) {
+            if (header) continue;
+            throw input_error(reader, "begin,end,value");
+        }
+        if (!(entry.keyBegin < entry.keyEnd)) {
+            throw input_error(reader, "begin < end");
+        }
+        batch.push_back(entry);
+        if (batch.size() == options.batch) {
+            imap.assign_batch(batch);
+            batch.clear();
+        }
+        if ((++rows & 0xffff) == 0) {
+            report.progress(reader.bytes_consumed(), reader.size(), rows);
+        }
+    }
+    imap.assign_batch(batch);
+    report.finish(reader.bytes_consumed(), rows, std::to_string(imap.size()) + " boundaries");
+}
+
+void answer_queries(tool_map const& imap, std::string const& path, line_writer& out, tool_options const& options) {
+    line_reader reader(path, options.map_input);
+    phase_report report("query " + path, options.quiet);
+
+    // Query files often walk the keys in order; the finger makes that cheap
+    tool_map::finger hint;
+    std::uint64_t rows = 0;
+    bool first = true;
+    std::string_view line;
+    while (reader.next(line)) {
+        if (skipped(line)) continue;
+        bool header = std::exchange(first, false);
+        key_type key;
+        if (!parse_fields(line, options.delimiter, key)) {
+            if (header) continue;
+            throw input_error(reader, "key");
+        }
+        out.write_fields(options.delimiter, key, imap.lookup(hint, key));
+        if ((++rows & 0xffff) == 0) {
+            report.progress(reader.bytes_consumed(), reader.size(), rows);
+        }
+    }
+    out.flush();
+    report.finish(reader.bytes_consumed(), rows, "");
+}
+
+void export_intervals(tool_map const& imap, tool_options const& options) {
+    line_writer out(options.export_path);
+    phase_report report("export " + options.export_path, options.quiet);
+
+    // Keys past the last boundary always hold the default value, so the
+    // intervals below the maximum key cover every assigned one
+    key_type const lowest = std::numeric_limits<key_type>::min();
+    key_type const highest = std::numeric_limits<key_type>::max();
+    std::uint64_t rows = 0;
+    imap.for_each_interval(lowest, highest, [&](key_type keyBegin, key_type keyEnd, value_type val) {
+        if (val == options.default_value) return;
+        out.write_fields(options.delimiter, keyBegin, keyEnd, val);
+        if ((++rows & 0xffff) == 0) {
+            report.progress(out.bytes_written(), 0, rows);
+        }
+    });
+    out.flush();
+    report.finish(out.bytes_written(), rows, "");
+}
+
+int run(tool_options const& options) {
+    tool_map imap(options.default_value);
+    for (std::string const& path : options.assign_paths) {
+        apply_assignments(imap, path, options);
+    }
+    if (!options.query_paths.empty()) {
+        line_writer out(options.out_path);
+        for (std::string const& path : options.query_paths) {
+            answer_queries(imap, path, out, options);
+        }
+    }
+    if (!options.export_path.empty()) {
+        export_intervals(imap, options);
+    }
+    if (!options.save_path.empty()) {
+        save_snapshot(imap, options.save_path);
+    }
+    if (!options.quiet) {
+        std::cerr << imap.size() << " boundaries, " << std::fixed << std::setprecision(1)
+                  << imap.get_storage().memory_usage() / 1e6 << " MB" << std::endl;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tool_options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--assign" && has_value) {
+            options.assign_paths.push_back(argv[++i]);
+        } else if (arg == "--query" && has_value) {
+            options.query_paths.push_back(argv[++i]);
+        } else if (arg == "--out" && has_value) {
+            options.out_path = argv[++i];
+        } else if (arg == "--export" && has_value) {
+            options.export_path = argv[++i];
+        } else if (arg == "--save" && has_value) {
+            options.save_path = argv[++i];
+        } else if (arg == "--delimiter" && has_value && std::string(argv[i + 1]).size() == 1) {
+            options.delimiter = argv[++i][0];
+        } else if (arg == "--mmap") {
+            options.map_input = true;
+        } else if (arg == "--quiet") {
+            options.quiet = true;
+        } else if ((arg == "--default" || arg == "--batch") && has_value) {
+            std::string number = argv[++i];
+            bool parsed = arg == "--default" ? parse_fields(number, ',', options.default_value)
+                                             : parse_fields(number, ',', options.batch) && options.batch > 0;
+            if (!parsed) {
+                print_usage(argv[0]);
+                return 2;
+            }
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.assign_paths.empty() && options.query_paths.empty() && options.export_path.empty()) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        return run(options);
+    } catch (const std::exception& e) {
+        std::cerr << "interval_map_tool: " << e.what() << std::endl;
+        return 1;
+    }
+}